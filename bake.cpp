@@ -0,0 +1,156 @@
+#include <cstdint>
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+#include <string_view>
+
+#include "fmt/format.h"
+
+#include "txt/fonts.hpp"
+#include "txt/font_pack.hpp"
+#include "txt/packer.hpp"
+
+// Bakes a typeface into a font pack, loaded with font_manager::load_pack without FreeType.
+//   txt-bake <font> <output> [--size N] [--mode M] [--scale S] [--face I] [--threads N] [--range FIRST-LAST]...
+// Ranges are half-open like character_range_t and take decimal or 0x prefixed hex, the default is the ASCII range.
+
+static auto usage() -> std::string {
+    return "Usage: txt-bake <font> <output> [--size N] [--mode normal|sdf|subpixel|raster|msdf] [--scale S] [--face I] [--threads N] [--range FIRST-LAST]...";
+}
+
+static auto parse_mode(std::string_view name) -> txt::text_render_mode {
+    if (name == "normal")   return txt::text_render_mode::normal;
+    if (name == "sdf")      return txt::text_render_mode::sdf;
+    if (name == "subpixel") return txt::text_render_mode::subpixel;
+    if (name == "raster")   return txt::text_render_mode::raster;
+    if (name == "msdf")     return txt::text_render_mode::msdf;
+    throw std::runtime_error(fmt::format("Unknown render mode '{}'!", name));
+}
+
+static auto parse_range(std::string const& value) -> txt::character_range_t {
+    auto const dash = value.find('-');
+    if (dash == std::string::npos) throw std::runtime_error(fmt::format("Range '{}' is not FIRST-LAST!", value));
+    auto const first = std::uint32_t(std::stoul(value.substr(0, dash), nullptr, 0));
+    auto const last  = std::uint32_t(std::stoul(value.substr(dash + 1), nullptr, 0));
+    if (last <= first) throw std::runtime_error(fmt::format("Range '{}' is empty!", value));
+    return {first, last};
+}
+
+static auto entry(std::vector<std::string_view> const& args) -> void {
+    if (args.size() < 3) throw std::runtime_error(usage());
+    txt::typeface_props props{
+        .filename = std::string{args[1]},
+        .size     = 16,
+        .family   = "bake",
+        .style    = "bake",
+        .threads  = 0,
+    };
+    std::string const output{args[2]};
+    std::vector<txt::character_range_t> ranges{};
+    for (std::size_t i = 3; i < args.size(); ++i) {
+        auto const option = args[i];
+        if (i + 1 == args.size()) throw std::runtime_error(fmt::format("Missing value for '{}'!\n{}", option, usage()));
+        std::string const value{args[++i]};
+        if (option == "--size")         props.size        = std::uint32_t(std::stoul(value));
+        else if (option == "--mode")    props.render_mode = parse_mode(value);
+        else if (option == "--scale")   props.scale       = std::stod(value);
+        else if (option == "--face")    props.face_index  = std::int32_t(std::stol(value));
+        else if (option == "--threads") props.threads     = std::uint32_t(std::stoul(value));
+        else if (option == "--range")   ranges.push_back(parse_range(value));
+        else throw std::runtime_error(fmt::format("Unknown option '{}'!\n{}", option, usage()));
+    }
+    if (ranges.empty()) ranges.push_back(txt::default_character_range);
+
+    // The first range loads on all workers, the rest is queried glyph by glyph.
+    props.ranges = ranges.front();
+    auto const manager = txt::make_ref<txt::font_manager>();
+    manager->load(props);
+    auto const tf = manager->family(props.family)->typeface(props.style);
+    for (std::size_t i = 1; i < ranges.size(); ++i) {
+        for (auto code = ranges[i][0]; code < ranges[i][1]; ++code)
+            tf->index(code);
+    }
+
+    auto const& glyphs = tf->glyphs();
+    // Laid out the way text_batch packs the atlas, so it is adopted as is at load time.
+    std::vector<glm::ivec2> sizes{};
+    sizes.reserve(glyphs.size());
+    for (auto const& gh : glyphs)
+        sizes.push_back({std::int32_t(gh.width), std::int32_t(gh.height)});
+    auto const baked = txt::layout_atlas(sizes, txt::atlas_padding, 0, txt::atlas_page_size);
+    auto const pages = baked.packers.size();
+    txt::image_u8 atlas{baked.page_size, baked.page_size * pages, tf->channels()};
+    std::vector<txt::glyph_cache_record> records{};
+    records.reserve(glyphs.size());
+    for (std::size_t i = 0; i < glyphs.size(); ++i) {
+        auto const& gh = glyphs[i];
+        auto const& position = baked.positions[i];
+        // Bitmap rows are top-down, atlas rows follow the texture and go bottom-up.
+        auto const x     = std::size_t(position.x);
+        auto const y     = std::size_t(position.z) * baked.page_size + std::size_t(position.y);
+        auto const pitch = std::size_t(gh.width) * tf->channels();
+        for (std::size_t row = 0; row < gh.height; ++row)
+            atlas.set_row(x, y + gh.height - 1 - row, tf->bitmap(gh) + row * pitch, gh.width);
+        records.push_back({
+            .codepoint     = gh.codepoint,
+            .bearing_left  = gh.bearing_left,
+            .bearing_top   = gh.bearing_top,
+            .width         = gh.width,
+            .height        = gh.height,
+            .uv_x          = float(position.x),
+            .uv_y          = float(position.y),
+            .page          = std::uint32_t(position.z),
+            .advance_x     = gh.advance_x,
+            .advance_y     = gh.advance_y,
+            .bitmap_offset = gh.offset,
+        });
+    }
+
+    // Every pair of the first baked glyphs, kept sorted for the binary search at runtime. Capped, a CJK
+    // range would take tens of millions of lookups.
+    std::vector<txt::font_pack_kerning> kerning{};
+    if (tf->has_kerning()) {
+        std::span<txt::glyph const> const kerned{glyphs.data(), std::min(glyphs.size(), txt::font_pack_kerned_glyphs)};
+        for (auto const& left : kerned) {
+            for (auto const& right : kerned) {
+                if (auto const x = tf->kerning(left.codepoint, right.codepoint); x != 0)
+                    kerning.push_back({left.codepoint, right.codepoint, x});
+            }
+        }
+    }
+    std::sort(std::begin(kerning), std::end(kerning), [](auto const& a, auto const& b) {
+        return a.left != b.left ? a.left < b.left : a.right < b.right;
+    });
+
+    txt::font_pack_header const header{
+        .size          = props.size,
+        .render_mode   = std::uint32_t(props.render_mode),
+        .scale         = props.scale,
+        .kerning_count = std::uint32_t(kerning.size()),
+    };
+    txt::glyph_cache_header const cache_header{
+        .key          = 0,
+        .channels     = std::uint32_t(tf->channels()),
+        .glyph_count  = std::uint32_t(records.size()),
+        .atlas_width  = std::uint32_t(atlas.width()),
+        .atlas_height = std::uint32_t(atlas.height()),
+        .padding      = std::uint32_t(txt::atlas_padding),
+        .pages        = std::uint32_t(pages),
+        .bitmap_bytes = tf->bitmaps().bytes(),
+    };
+    if (!txt::write_font_pack(output, header, kerning, cache_header, records, tf->bitmaps().buffer(), atlas))
+        throw std::runtime_error(fmt::format("Failed to write font pack '{}'!", output));
+    fmt::print("Baked {} glyphs, {} kerning pairs and {} atlas page(s) of {}px into '{}'\n",
+               records.size(), kerning.size(), pages, baked.page_size, output);
+}
+
+auto main(int argc, char const* argv[]) -> int {
+    try {
+        entry({argv, std::next(argv, argc)});
+    } catch (std::exception const& e) {
+        fmt::print(stderr, "Error at entry: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
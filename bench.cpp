@@ -0,0 +1,121 @@
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "txt/fonts.hpp"
+
+// Glyph lookup throughput of the layout loop in text_engine::text(), without GL.
+//   txt-bench [font] [--runs N]
+// The text is 100k characters, 80% ASCII and the rest drawn from every loaded glyph of U+0000-U+3000.
+// Node based is how glyphs were looked up before the glyph table: an unordered_map of glyphs by codepoint
+// and a std::map of atlas positions. Flat is glyph_table and the metrics arrays as text() uses them.
+
+struct instance {
+    glm::vec4 color;
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::vec2 uv_offset;
+    glm::vec2 uv_size;
+};
+
+static auto usage() -> std::string {
+    return "Usage: txt-bench [font] [--runs N]";
+}
+
+// Best of runs, in glyphs per second.
+template <typename F>
+static auto measure(std::size_t runs, std::size_t glyphs, F&& layout) -> double {
+    auto best = std::chrono::duration<double>::max();
+    for (std::size_t i = 0; i < runs; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        layout();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start));
+    }
+    return double(glyphs) / best.count();
+}
+
+static auto entry(std::vector<std::string_view> const& args) -> void {
+    std::string font{"res/fonts/RobotoMono/RobotoMonoNerdFontMono-Regular.ttf"};
+    std::size_t runs = 50;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--runs") {
+            if (i + 1 == args.size()) throw std::runtime_error(fmt::format("Missing value for '--runs'!\n{}", usage()));
+            runs = std::max(std::size_t(std::stoul(std::string{args[++i]})), std::size_t(1));
+        } else {
+            font = std::string{args[i]};
+        }
+    }
+
+    auto const manager = txt::make_ref<txt::font_manager>();
+    manager->load({.filename = font, .size = 16, .family = "bench", .style = "bench", .ranges = {0, 0x3000}, .threads = 0});
+    auto const tf = manager->family("bench")->typeface("bench");
+    auto const& glyphs = tf->glyphs();
+
+    std::vector<std::uint32_t> codes{};
+    for (auto const& gh : glyphs) codes.push_back(gh.codepoint);
+    std::sort(std::begin(codes), std::end(codes));
+    std::mt19937 rng{1};
+    std::vector<std::uint32_t> text{};
+    for (std::size_t i = 0; i < 100'000; ++i)
+        text.push_back(rng() % 10 < 8 ? std::uint32_t(32 + rng() % 95) : codes[rng() % codes.size()]);
+    std::vector<instance> out(text.size());
+
+    // Atlas positions are made up, only the lookup matters.
+    std::unordered_map<std::uint32_t, txt::glyph> glyph_nodes{};
+    std::map<std::uint32_t, glm::vec2> uv_nodes{};
+    std::vector<glm::vec2> uvs{};
+    for (auto const& gh : glyphs) {
+        glm::vec2 const uv{float(gh.codepoint % 64), float(gh.codepoint / 64)};
+        glyph_nodes.insert({gh.codepoint, gh});
+        uv_nodes.insert({gh.codepoint, uv});
+        uvs.push_back(uv);
+    }
+
+    auto const node_based = measure(runs, text.size(), [&] {
+        glm::vec2 pos{0.0f};
+        std::size_t n = 0;
+        for (auto const code : text) {
+            auto const it = glyph_nodes.find(code);
+            auto const& gh = it != std::end(glyph_nodes) ? it->second : glyph_nodes.at(' ');
+            auto const xpos = float(gh.bearing_left) + pos.x;
+            auto const ypos = -(float(gh.height) - float(gh.bearing_top)) + pos.y;
+            out[n++] = {glm::vec4{1.0f}, {xpos, ypos, 0.0f}, glm::vec3{1.0f}, uv_nodes.at(gh.codepoint), {float(gh.width), float(gh.height)}};
+            pos.x += float(gh.advance_x >> 6);
+        }
+    });
+    auto const flat = measure(runs, text.size(), [&] {
+        glm::vec2 pos{0.0f};
+        std::size_t n = 0;
+        auto const& m = tf->metrics();
+        for (auto const code : text) {
+            auto const index = tf->index(code);
+            auto const w = float(m.width[index]);
+            auto const h = float(m.height[index]);
+            auto const xpos = float(m.bearing_left[index]) + pos.x;
+            auto const ypos = -(h - float(m.bearing_top[index])) + pos.y;
+            out[n++] = {glm::vec4{1.0f}, {xpos, ypos, 0.0f}, glm::vec3{1.0f}, uvs[index], {w, h}};
+            pos.x += float(m.advance_x[index] >> 6);
+        }
+    });
+
+    fmt::print("{} glyphs loaded, {} characters, best of {} runs\n", glyphs.size(), text.size(), runs);
+    fmt::print("  node based (unordered_map + std::map): {:7.1f} Mglyphs/s\n", node_based / 1e6);
+    fmt::print("  flat (glyph_table + metrics arrays):   {:7.1f} Mglyphs/s\n", flat / 1e6);
+}
+
+auto main(int argc, char const* argv[]) -> int {
+    try {
+        entry({argv, std::next(argv, argc)});
+    } catch (std::exception const& e) {
+        fmt::print(stderr, "Error at entry: {}\n", e.what());
+        return 1;
+    }
+    return 0;
+}
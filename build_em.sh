@@ -1,6 +1,9 @@
 #!/usr/bin/env sh
 
 preload_files="--preload-file ./shaders/webgl --preload-file ./res/fonts"
+if [ -d ./res/packs ]; then
+    preload_files="${preload_files} --preload-file ./res/packs"  # Font packs baked with txt-bake
+fi
 
 # flags
 is_rebuild=false
@@ -50,6 +50,11 @@ static auto entry([[maybe_unused]]std::vector<std::string_view> const& args) ->
     glm::vec2 const text_padding{8.0f, 4.0f};
     glm::vec3 color{1.0f};
 
+    // Laid out once, moving and recoloring it only changes its transform.
+    txt::text_object hello{};
+    txt::layout(hello, "Hello, World!");
+    hello.set_scale(glm::vec2{scale});
+
     std::random_device rdevice;
     std::mt19937 rng{rdevice()};
     std::uniform_int_distribution<std::mt19937::result_type> dist(0, 360);
@@ -81,7 +86,9 @@ static auto entry([[maybe_unused]]std::vector<std::string_view> const& args) ->
         }
 
         txt::rect(text_pos, txt_size + text_padding, 0.0f, {color, 1.0f});
-        txt::text("Hello, World!", text_pos - txt_size / 2.0f, {color * 0.25f, 1.0f}, glm::vec2{scale});
+        hello.set_position(text_pos - txt_size / 2.0f);
+        hello.set_color({color * 0.25f, 1.0f});
+        txt::text(hello);
         txt::end_frame();
 
         window->swap();
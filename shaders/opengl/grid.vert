@@ -0,0 +1,49 @@
+#version 410
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec2 a_uv;
+
+// Instancing, one per cell as in cell_grid::gpu
+layout(location = 2) in float a_glyph;
+layout(location = 3) in vec4  a_fg;
+layout(location = 4) in vec4  a_bg;
+
+// Matches glyph_table_width, see text.vert.
+#define GLYPHS_PER_ROW 512
+
+out vec2 _cell;              // Position within the cell in atlas pixels
+flat out vec4 _glyph;        // Bottom left of the glyph within the cell, then its size
+flat out vec3 _uv_offset;    // Atlas position and page
+flat out vec4 _fg;
+flat out vec4 _bg;
+
+uniform mat4  u_view       = mat4(1.0);
+uniform mat4  u_projection = mat4(1.0);
+uniform vec3  u_origin;      // Top left of the grid
+uniform vec2  u_cell;        // Cell size in atlas pixels
+uniform vec2  u_scale;       // Atlas pixels to screen
+uniform float u_descent;     // Baseline above the bottom of the cell
+uniform int   u_rows;
+uniform int   u_cols;
+uniform int   u_first_row;   // Storage row shown at the top
+uniform isampler2D u_glyphs;
+
+void main() {
+    // Cells are stored row by row in a ring, the shown row is relative to the first one.
+    int row    = gl_InstanceID / u_cols;
+    int col    = gl_InstanceID % u_cols;
+    int shown  = (row - u_first_row + u_rows) % u_rows;
+
+    int   index = int(a_glyph);
+    ivec2 entry = ivec2((index % GLYPHS_PER_ROW) * 2, index / GLYPHS_PER_ROW);
+    ivec4 atlas = texelFetch(u_glyphs, entry, 0);
+    ivec4 size  = texelFetch(u_glyphs, entry + ivec2(1, 0), 0);
+
+    _cell      = a_uv * u_cell;
+    _glyph     = vec4(float(size.z), u_descent + float(size.w - size.y), vec2(size.xy));
+    _uv_offset = vec3(atlas.xyz);
+    _fg        = a_fg;
+    _bg        = a_bg;
+
+    vec2 corner = (vec2(col, -(shown + 1)) + a_position.xy) * u_cell * u_scale;
+    gl_Position = u_projection * u_view * vec4(u_origin.xy + corner, u_origin.z, 1.0);
+}
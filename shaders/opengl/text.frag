@@ -7,34 +7,45 @@ layout(location = 0, index = 1) out vec4 color_mask;
 #endif
 #define SUBPIXEL 1
 #define SDF 2
+#define MSDF 3
 
 in vec2 _uv;
 in vec2 _uv_offset;
+flat in float _page;
 in vec2 _uv_size;
 in vec4 _color;
 // in vec2 _scale;
 
-uniform vec2      u_size;     // Texture size
-uniform sampler2D u_texture;  // Texture slot
+uniform vec2           u_size;     // Atlas page size
+uniform sampler2DArray u_texture;  // Texture slot, one layer per atlas page
 
 void main() {
-    vec2 uv = vec2(
+    vec3 uv = vec3(
         _uv.x * (_uv_size.x / u_size.x) + (_uv_offset.x / u_size.x),
-        _uv.y * (_uv_size.y / u_size.y) + (_uv_offset.y / u_size.y)
+        _uv.y * (_uv_size.y / u_size.y) + (_uv_offset.y / u_size.y),
+        _page
     );
 
-
-// #if RENDER_MODE == SUBPIXEL
-//     vec4 s = texture(u_texture, uv);  // Texture sample
-//     color = _color;
-//     color_mask = _color.a * s;
-// #elif RENDER_MODE == SDF
-//     float d = texture(u_texture, uv).r;
-//     float aaf = fwidth(d);
-//     float a = smoothstep(0.5 - aaf, 0.5 + aaf, d);
-//     color = vec4(_color.rgb, a);
-// #else
+#if RENDER_MODE == SDF
+    // Distance is stored as 0.5 on the outline, antialias over one screen pixel whatever the scale.
+    float d = texture(u_texture, uv).r;
+    float w = fwidth(d);
+    float a = smoothstep(0.5 - w, 0.5 + w, d);
+    color = vec4(_color.rgb, _color.a * a);
+#elif RENDER_MODE == MSDF
+    // Each channel is a distance to differently colored edges, their median is the distance to the outline.
+    vec3 s = texture(u_texture, uv).rgb;
+    float d = max(min(s.r, s.g), min(max(s.r, s.g), s.b));
+    float w = fwidth(d);
+    float a = smoothstep(0.5 - w, 0.5 + w, d);
+    color = vec4(_color.rgb, _color.a * a);
+#elif RENDER_MODE == SUBPIXEL
+    // Dual-source blending, every subpixel is blended with its own coverage from the LCD bitmap.
+    vec3 s = texture(u_texture, uv).rgb;
+    color = vec4(_color.rgb, 1.0);
+    color_mask = vec4(_color.a * s, 1.0);
+#else
     float d = texture(u_texture, uv).r;
     color = vec4(_color.rgb, d);
-// #endif
+#endif
 }
@@ -2,15 +2,19 @@
 layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec2 a_uv;
 
-// Instancing
-layout(location = 2) in vec4 a_color;
-layout(location = 3) in vec3 a_tp;  // Transform position
-layout(location = 4) in vec3 a_ts;  // Transform scale
-layout(location = 5) in vec2 a_uv_offset;
-layout(location = 6) in vec2 a_uv_size;
+// Instancing, fixed point as in text_batch::gpu
+layout(location = 2) in vec2 a_tp;     // Pen position in quarter pixels
+layout(location = 3) in vec2 a_glyph;  // x is the glyph index, y the depth in 1/64
+layout(location = 4) in vec4 a_color;
+layout(location = 5) in vec2 a_ts;     // Transform scale, 8.8
+
+// Glyph table, two texels per glyph: atlas position and page, then size and bearings. Matches
+// glyph_table_width.
+#define GLYPHS_PER_ROW 512
 
 out vec2 _uv;
 out vec2 _uv_offset;
+flat out float _page;
 out vec2 _uv_size;
 out vec4 _color;
 // out vec2 _scale;
@@ -18,22 +22,34 @@ out vec4 _color;
 uniform mat4 u_model      = mat4(1.0);
 uniform mat4 u_view       = mat4(1.0);
 uniform mat4 u_projection = mat4(1.0);
+uniform vec4 u_color      = vec4(1.0);  // Tint of every instance
+uniform isampler2D u_glyphs;
 
 void main() {
+    int   index = int(a_glyph.x);
+    ivec2 entry = ivec2((index % GLYPHS_PER_ROW) * 2, index / GLYPHS_PER_ROW);
+    ivec4 atlas = texelFetch(u_glyphs, entry, 0);
+    ivec4 size  = texelFetch(u_glyphs, entry + ivec2(1, 0), 0);
+    vec2  ts    = a_ts / 256.0;
+    // Bottom left of the quad, the bearings scale with the glyph.
+    vec2  pen   = a_tp / 4.0 + vec2(size.z, size.w - size.y) * ts;
+    vec3  tp    = vec3(pen, a_glyph.y / 64.0);
+
     _uv        = a_uv;
-    _color     = a_color;
-    _uv_offset = a_uv_offset;
-    _uv_size   = a_uv_size;
+    _color     = a_color * u_color;
+    _uv_offset = vec2(atlas.xy);
+    _page      = float(atlas.z);
+    _uv_size   = vec2(size.xy);
 
     mat4 model = transpose(mat4(
-        vec4(1.0, 0.0, 0.0, a_tp.x),
-        vec4(0.0, 1.0, 0.0, a_tp.y),
-        vec4(0.0, 0.0, 1.0, a_tp.z),
+        vec4(1.0, 0.0, 0.0, tp.x),
+        vec4(0.0, 1.0, 0.0, tp.y),
+        vec4(0.0, 0.0, 1.0, tp.z),
         vec4(0.0, 0.0, 0.0, 1.0)
     ));
     model *= transpose(mat4(
-        vec4(_uv_size.x * a_ts.x, 0.0, 0.0, 0.0),
-        vec4(0.0, _uv_size.y * a_ts.y, 0.0, 0.0),
+        vec4(_uv_size.x * ts.x, 0.0, 0.0, 0.0),
+        vec4(0.0, _uv_size.y * ts.y, 0.0, 0.0),
         vec4(0.0, 0.0, 1.0, 0.0),
         vec4(0.0, 0.0, 0.0, 1.0)
     ));
@@ -0,0 +1,46 @@
+#version 300 es
+precision mediump float;
+precision mediump sampler2DArray;
+
+layout(location = 0) out vec4 color;
+
+#ifndef RENDER_MODE
+#define RENDER_MODE 0
+#endif
+#define SUBPIXEL 1
+#define SDF 2
+#define MSDF 3
+
+in vec2 _cell;
+flat in vec4 _glyph;
+flat in vec3 _uv_offset;
+flat in vec4 _fg;
+flat in vec4 _bg;
+
+uniform vec2           u_size;
+uniform sampler2DArray u_texture;
+
+void main() {
+    // The quad covers the whole cell, the glyph only part of it.
+    vec2 p = _cell - _glyph.xy;
+    bool inside = all(greaterThanEqual(p, vec2(0.0))) && all(lessThan(p, _glyph.zw));
+    vec3 uv = vec3((_uv_offset.xy + clamp(p, vec2(0.0), _glyph.zw)) / u_size, _uv_offset.z);
+
+#if RENDER_MODE == SDF
+    float d = texture(u_texture, uv).r;
+    float w = fwidth(d);
+    vec3 a = vec3(inside ? smoothstep(0.5 - w, 0.5 + w, d) : 0.0);
+#elif RENDER_MODE == MSDF
+    vec3 s = texture(u_texture, uv).rgb;
+    float d = max(min(s.r, s.g), min(max(s.r, s.g), s.b));
+    float w = fwidth(d);
+    vec3 a = vec3(inside ? smoothstep(0.5 - w, 0.5 + w, d) : 0.0);
+#elif RENDER_MODE == SUBPIXEL
+    // The background is known here, every subpixel is mixed with it on its own without dual-source blending.
+    vec3 a = inside ? texture(u_texture, uv).rgb : vec3(0.0);
+#else
+    vec3 a = vec3(inside ? texture(u_texture, uv).r : 0.0);
+#endif
+    vec3 coverage = a * _fg.a;
+    color = vec4(mix(_bg.rgb, _fg.rgb, coverage), max(_bg.a, max(coverage.r, max(coverage.g, coverage.b))));
+}
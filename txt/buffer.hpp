@@ -24,6 +24,7 @@ enum class type : std::uint32_t {
     f16,   f32,   f64,
     vec2,  vec3,  vec4,
     ivec2, ivec3, ivec4,
+    u8vec4, i16vec2, u16vec2,  // Packed attributes
     dvec2, dvec3, dvec4,
     mat2,  mat3,  mat4,
 };
@@ -58,13 +59,16 @@ inline constexpr auto gl_usage(txt::usage const& usage) -> GLenum {
 inline constexpr auto gl_attribute_type(txt::type const& type) -> GLenum {
     switch (type) {
         case txt::type::i8:    return GL_BYTE;
-        case txt::type::i16:   return GL_SHORT;
+        case txt::type::i16:
+        case txt::type::i16vec2: return GL_SHORT;
         case txt::type::i32:
         case txt::type::ivec2:
         case txt::type::ivec3:
         case txt::type::ivec4: return GL_INT;
-        case txt::type::u8:    return GL_UNSIGNED_BYTE;
-        case txt::type::u16:   return GL_UNSIGNED_SHORT;
+        case txt::type::u8:
+        case txt::type::u8vec4:  return GL_UNSIGNED_BYTE;
+        case txt::type::u16:
+        case txt::type::u16vec2: return GL_UNSIGNED_SHORT;
         case txt::type::u32:   return GL_UNSIGNED_INT;
         case txt::type::f64:   return GL_DOUBLE;
         default:               return GL_FLOAT;
@@ -75,6 +79,8 @@ inline constexpr auto gl_component_count(txt::type const& type) -> GLint {
     switch(type) {
         case txt::type::vec2:
         case txt::type::ivec2:
+        case txt::type::i16vec2:
+        case txt::type::u16vec2:
         case txt::type::dvec2: return 2;
 
         case txt::type::vec3:
@@ -83,6 +89,7 @@ inline constexpr auto gl_component_count(txt::type const& type) -> GLint {
 
         case txt::type::vec4:
         case txt::type::ivec4:
+        case txt::type::u8vec4:
         case txt::type::dvec4: return 4;
 
         case txt::type::mat2:  return 2 * 2;
@@ -120,7 +127,10 @@ inline constexpr auto gl_type_size(txt::type const& type) -> std::size_t {
         case txt::type::i32:
         case txt::type::u32:
         case txt::type::p32:
-        case txt::type::f32:   return 4;
+        case txt::type::f32:
+        case txt::type::u8vec4:
+        case txt::type::i16vec2:
+        case txt::type::u16vec2: return 4;
 
         case txt::type::i64:
         case txt::type::u64:
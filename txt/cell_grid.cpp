@@ -0,0 +1,123 @@
+#include "cell_grid.hpp"
+#include "unicode.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace txt {
+// Dirty runs closer than this many cells are uploaded as one range.
+static constexpr std::size_t merge_gap = 64;
+
+static auto to_rgba8(glm::vec4 const& color) -> glm::u8vec4 {
+    auto const channel = [](float value) { return std::uint8_t(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f)); };
+    return {channel(color.x), channel(color.y), channel(color.z), channel(color.w)};
+}
+
+cell_grid::cell_grid(typeface_ref_t typeface, std::size_t rows, std::size_t cols)
+    : m_typeface(std::move(typeface))
+    , m_rows(rows)
+    , m_cols(cols) {
+    if (m_typeface == nullptr) throw std::runtime_error("Cell grid needs a typeface!");
+    if (rows == 0 || cols == 0) throw std::runtime_error(fmt::format("Cell grid of {}x{} has no cells!", rows, cols));
+    m_generation = m_typeface->generation();
+    m_codes.assign(rows * cols, ' ');
+    m_cells.assign(rows * cols, {.glyph = resolve(' '), .fg = to_rgba8(glm::vec4{1.0f}), .bg = to_rgba8({0.0f, 0.0f, 0.0f, 1.0f})});
+    m_dirty.assign((rows * cols + 63) / 64, 0);
+    mark(0, rows * cols);
+}
+
+auto cell_grid::cell_size() const -> glm::vec2 {
+    auto& face = *m_typeface;
+    auto const& gh = face.glyphs()[face.index(' ')];
+    auto const unit = face.layout_scale() / 64.0f;
+    return {std::round(float(gh.advance_x) * unit), std::round(float(gh.advance_y) * unit)};
+}
+
+auto cell_grid::set(std::size_t row, std::size_t col, std::uint32_t code, glm::vec4 const& fg, glm::vec4 const& bg) -> void {
+    if (row >= m_rows || col >= m_cols) throw std::runtime_error(fmt::format("Cell {}, {} is outside of the {}x{} grid!", row, col, m_rows, m_cols));
+    auto const i = cell(row, col);
+    m_codes[i] = code;
+    m_cells[i] = {.glyph = resolve(code), .fg = to_rgba8(fg), .bg = to_rgba8(bg)};
+    mark(i, i + 1);
+}
+auto cell_grid::write(std::size_t row, std::size_t col, std::string_view str, glm::vec4 const& fg, glm::vec4 const& bg) -> std::size_t {
+    if (row >= m_rows) throw std::runtime_error(fmt::format("Row {} is outside of the {}x{} grid!", row, m_rows, m_cols));
+    auto const fg8 = to_rgba8(fg);
+    auto const bg8 = to_rgba8(bg);
+    auto const first = cell(row, 0);
+    for_each_codepoint(str, [&](std::uint32_t code) {
+        if (col >= m_cols) return;
+        m_codes[first + col] = code;
+        m_cells[first + col] = {.glyph = resolve(code), .fg = fg8, .bg = bg8};
+        mark(first + col, first + col + 1);
+        ++col;
+    });
+    return col;
+}
+auto cell_grid::clear_row(std::size_t row, glm::vec4 const& fg, glm::vec4 const& bg) -> void {
+    if (row >= m_rows) throw std::runtime_error(fmt::format("Row {} is outside of the {}x{} grid!", row, m_rows, m_cols));
+    auto const first = cell(row, 0);
+    gpu const blank{.glyph = resolve(' '), .fg = to_rgba8(fg), .bg = to_rgba8(bg)};
+    std::fill_n(std::begin(m_codes) + std::ptrdiff_t(first), m_cols, std::uint32_t(' '));
+    std::fill_n(std::begin(m_cells) + std::ptrdiff_t(first), m_cols, blank);
+    mark(first, first + m_cols);
+}
+auto cell_grid::scroll(std::size_t count, glm::vec4 const& fg, glm::vec4 const& bg) -> void {
+    count = std::min(count, m_rows);
+    // The top rows become the bottom ones, only they change.
+    m_first_row = (m_first_row + count) % m_rows;
+    for (auto row = m_rows - count; row < m_rows; ++row)
+        clear_row(row, fg, bg);
+}
+
+auto cell_grid::resolve(std::uint32_t code) -> std::uint32_t {
+    auto const index = m_typeface->index(code);
+    if (m_known.size() <= index) m_known.resize(index + 1, false);
+    if (!m_known[index]) {
+        m_known[index] = true;
+        m_glyphs.push_back(index);
+    }
+    return index;
+}
+auto cell_grid::mark(std::size_t first, std::size_t last) -> void {
+    for (auto i = first; i < last; ++i)
+        m_dirty[i / 64] |= std::uint64_t(1) << (i % 64);
+    m_any_dirty = m_any_dirty || first < last;
+}
+auto cell_grid::refresh() -> void {
+    if (m_typeface->generation() == m_generation) return;
+    m_generation = m_typeface->generation();
+    m_glyphs.clear();
+    m_known.clear();
+    // Only cells whose glyph index moved are uploaded again, e.g. after a fallback covers a missing glyph.
+    for (std::size_t i = 0; i < m_codes.size(); ++i) {
+        auto const glyph = resolve(m_codes[i]);
+        if (glyph == m_cells[i].glyph) continue;
+        m_cells[i].glyph = glyph;
+        mark(i, i + 1);
+    }
+}
+auto cell_grid::take_dirty(std::vector<cell_range>& ranges) -> void {
+    ranges.clear();
+    if (!m_any_dirty) return;
+    for (std::size_t word = 0; word < m_dirty.size(); ++word) {
+        auto bits = m_dirty[word];
+        m_dirty[word] = 0;
+        while (bits != 0) {
+            // Next run of set bits in the word
+            auto const start = std::size_t(std::countr_zero(bits));
+            auto const length = std::size_t(std::countr_one(bits >> start));
+            auto const first = word * 64 + start;
+            auto const last  = first + length;
+            if (!ranges.empty() && first - ranges.back().second < merge_gap)
+                ranges.back().second = last;
+            else
+                ranges.emplace_back(first, last);
+            bits = length + start >= 64 ? 0 : bits & ~(((std::uint64_t(1) << length) - 1) << start);
+        }
+    }
+    m_any_dirty = false;
+}
+} // namespace txt
@@ -0,0 +1,86 @@
+#ifndef TXT_CELL_GRID_HPP
+#define TXT_CELL_GRID_HPP
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+#include "glm/gtc/type_precision.hpp"
+
+#include "utility.hpp"
+#include "fonts.hpp"
+#include "buffer.hpp"
+
+namespace txt {
+class text_engine;
+
+// Fixed rows x cols of monospace cells for terminal-like views, every cell is a codepoint with a foreground
+// and background color. Cells live in a buffer on the GPU, only the ones changed since the last draw are
+// uploaded again and the grid is drawn in a single instanced call, backgrounds together with the glyphs.
+//
+// Rows are stored as a ring, scrolling moves the row shown at the top and clears the rows coming in
+// instead of moving every cell.
+class cell_grid {
+public:
+    struct gpu {
+        std::uint32_t glyph;  // Glyph index of the typeface
+        glm::u8vec4   fg;
+        glm::u8vec4   bg;
+    };
+    static_assert(sizeof(gpu) == 12);
+
+public:
+    cell_grid(typeface_ref_t typeface, std::size_t rows, std::size_t cols);
+    ~cell_grid() = default;
+    cell_grid(cell_grid const&) = delete;
+    auto operator=(cell_grid const&) -> cell_grid& = delete;
+
+    auto rows() const -> std::size_t { return m_rows; }
+    auto cols() const -> std::size_t { return m_cols; }
+    auto typeface() const -> typeface_ref_t const& { return m_typeface; }
+    // Advance of ' ' by the line height in layout units at scale 1, rounded to whole pixels.
+    auto cell_size() const -> glm::vec2;
+
+    auto code(std::size_t row, std::size_t col) const -> std::uint32_t { return m_codes[cell(row, col)]; }
+    auto set(std::size_t row, std::size_t col, std::uint32_t code, glm::vec4 const& fg = glm::vec4{1.0f}, glm::vec4 const& bg = {0.0f, 0.0f, 0.0f, 1.0f}) -> void;
+    // One codepoint per cell from col on, cut at the end of the row. Returns the column after the text.
+    auto write(std::size_t row, std::size_t col, std::string_view str, glm::vec4 const& fg = glm::vec4{1.0f}, glm::vec4 const& bg = {0.0f, 0.0f, 0.0f, 1.0f}) -> std::size_t;
+    auto clear_row(std::size_t row, glm::vec4 const& fg = glm::vec4{1.0f}, glm::vec4 const& bg = {0.0f, 0.0f, 0.0f, 1.0f}) -> void;
+    // Moves the content up by count rows, the rows at the bottom are cleared.
+    auto scroll(std::size_t count, glm::vec4 const& fg = glm::vec4{1.0f}, glm::vec4 const& bg = {0.0f, 0.0f, 0.0f, 1.0f}) -> void;
+
+private:
+    friend class text_engine;
+    using cell_range = std::pair<std::size_t, std::size_t>;  // [first, last) in storage order
+
+    auto cell(std::size_t row, std::size_t col) const -> std::size_t { return ((m_first_row + row) % m_rows) * m_cols + col; }
+    auto resolve(std::uint32_t code) -> std::uint32_t;
+    auto mark(std::size_t first, std::size_t last) -> void;
+    // Looks every glyph index up again when the typeface's changed, only cells whose index moved are marked.
+    auto refresh() -> void;
+    // Ranges of dirty cells, close ones merged to save upload calls. Clears the dirty bits.
+    auto take_dirty(std::vector<cell_range>& ranges) -> void;
+
+private:
+    typeface_ref_t m_typeface;
+    std::uint64_t  m_generation{0};
+    std::size_t    m_rows;
+    std::size_t    m_cols;
+    std::size_t    m_first_row{0};  // Storage row shown at the top
+
+    std::vector<std::uint32_t> m_codes{};
+    std::vector<gpu>           m_cells{};
+    std::vector<std::uint64_t> m_dirty{};   // One bit per cell
+    bool                       m_any_dirty{false};
+    std::vector<std::uint32_t> m_glyphs{};  // Every glyph index used so far, kept in the atlas while drawn
+    std::vector<bool>          m_known{};   // Per glyph index, in m_glyphs
+
+    vertex_buffer_ref_t        m_buffer{nullptr};
+    attribute_descriptor_ref_t m_descriptor{nullptr};
+};
+} // namespace txt
+
+#endif  // TXT_CELL_GRID_HPP
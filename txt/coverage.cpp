@@ -0,0 +1,22 @@
+#include "coverage.hpp"
+
+namespace txt {
+auto coverage_set::insert(std::uint32_t const& code) -> void {
+    auto const block = code >> block_bits;
+    if (block >= m_blocks.size()) m_blocks.resize(block + 1, empty);
+    if (m_blocks[block] == empty) {
+        m_blocks[block] = std::uint32_t(m_bits.size() / words_per_block);
+        m_bits.resize(m_bits.size() + words_per_block, 0);
+    }
+    auto const bit = code & block_mask;
+    auto& word = m_bits[std::size_t(m_blocks[block]) * words_per_block + (bit >> 6)];
+    auto const mask = std::uint64_t(1) << (bit & 63);
+    if ((word & mask) == 0) ++m_size;
+    word |= mask;
+}
+auto coverage_set::clear() -> void {
+    m_size = 0;
+    m_blocks.clear();
+    m_bits.clear();
+}
+} // namespace txt
@@ -0,0 +1,42 @@
+#ifndef TXT_COVERAGE_HPP
+#define TXT_COVERAGE_HPP
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "utility.hpp"
+
+namespace txt {
+// Set of codepoints, e.g. everything a face has a glyph for. Blocks of 256 codepoints are bitsets that
+// are only allocated when something in the block is inserted, a lookup is two loads and a bit test.
+class coverage_set {
+public:
+    coverage_set() = default;
+    ~coverage_set() = default;
+
+    auto size() const -> std::size_t { return m_size; }
+    auto contains(std::uint32_t const& code) const -> bool {
+        auto const block = code >> block_bits;
+        if (block >= m_blocks.size()) return false;
+        auto const index = m_blocks[block];
+        if (index == empty) return false;
+        auto const bit = code & block_mask;
+        return (m_bits[std::size_t(index) * words_per_block + (bit >> 6)] >> (bit & 63)) & 1;
+    }
+    auto insert(std::uint32_t const& code) -> void;
+    auto clear() -> void;
+
+private:
+    static constexpr std::uint32_t block_bits      = 8;
+    static constexpr std::uint32_t block_mask      = (1 << block_bits) - 1;
+    static constexpr std::size_t   words_per_block = (1 << block_bits) / 64;
+    static constexpr std::uint32_t empty           = limits<std::uint32_t>::max();
+
+private:
+    std::size_t                m_size{0};
+    std::vector<std::uint32_t> m_blocks{};  // Block number to its bitset in m_bits
+    std::vector<std::uint64_t> m_bits{};
+};
+} // namespace txt
+
+#endif  // TXT_COVERAGE_HPP
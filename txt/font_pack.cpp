@@ -0,0 +1,57 @@
+#include "font_pack.hpp"
+#include <fstream>
+#include <stdexcept>
+
+namespace txt {
+static auto cache_offset(font_pack_header const& header) -> std::size_t {
+    return sizeof(font_pack_header) + std::size_t(header.kerning_count) * sizeof(font_pack_kerning);
+}
+
+font_pack::font_pack(mapped_file_ref_t file) : m_file(file) {
+    auto const base = m_file->data();
+    m_header  = reinterpret_cast<font_pack_header const*>(base);
+    m_kerning = {reinterpret_cast<font_pack_kerning const*>(base + sizeof(font_pack_header)), m_header->kerning_count};
+    m_cache   = make_ref<glyph_cache>(m_file, cache_offset(*m_header));
+}
+
+auto open_font_pack(std::filesystem::path const& filename) -> font_pack_ref_t {
+    if (!std::filesystem::exists(filename))
+        throw std::runtime_error(fmt::format("Font pack path '{}' does not exist!", filename.string()));
+    auto const file = make_mapped_file(filename);
+    auto const invalid = [&](char const* reason) {
+        return std::runtime_error(fmt::format("Font pack '{}' is invalid, {}.", filename.string(), reason));
+    };
+    if (file->size() < sizeof(font_pack_header)) throw invalid("file is truncated");
+
+    auto const& header = *reinterpret_cast<font_pack_header const*>(file->data());
+    if (header.magic != font_pack_magic) throw invalid("not a font pack");
+    if (header.version != font_pack_version) throw invalid("baked for another version, bake it again");
+    auto const offset = cache_offset(header);
+    if (file->size() < offset) throw invalid("file is truncated");
+    if (auto const error = glyph_cache_error({file->data() + offset, file->size() - offset}); error != nullptr) throw invalid(error);
+    return make_ref<font_pack>(file);
+}
+
+auto write_font_pack(std::filesystem::path const& filename, font_pack_header const& header,
+                     std::vector<font_pack_kerning> const& kerning,
+                     glyph_cache_header const& cache_header,
+                     std::vector<glyph_cache_record> const& records,
+                     std::vector<std::uint8_t> const& bitmaps,
+                     image_u8 const& atlas) -> bool {
+    std::error_code ec{};
+    if (filename.has_parent_path()) std::filesystem::create_directories(filename.parent_path(), ec);
+    if (ec) return false;
+
+    auto tmp = filename;
+    tmp += ".tmp";
+    {
+        std::ofstream output{tmp, std::ios::binary | std::ios::trunc};
+        if (!output.is_open()) return false;
+        output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        output.write(reinterpret_cast<char const*>(kerning.data()), std::streamsize(kerning.size() * sizeof(font_pack_kerning)));
+        if (!write_glyph_cache(output, cache_header, records, {}, bitmaps, atlas)) return false;
+    }
+    std::filesystem::rename(tmp, filename, ec);
+    return !ec;
+}
+} // namespace txt
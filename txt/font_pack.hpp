@@ -0,0 +1,70 @@
+#ifndef TXT_FONT_PACK_HPP
+#define TXT_FONT_PACK_HPP
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <filesystem>
+
+#include "utility.hpp"
+#include "image.hpp"
+#include "mapped_file.hpp"
+#include "glyph_cache.hpp"
+
+namespace txt {
+// Typeface baked offline by txt-bake, loaded without FreeType. On-disk layout, the file is memory mapped
+// and read in place:
+//   font_pack_header
+//   font_pack_kerning[kerning_count], sorted by left then right codepoint
+//   glyph cache with key 0 and no kerning of its own, see glyph_cache.hpp
+// Kerning holds the pairs among the first font_pack_kerned_glyphs glyphs, in the order of the baked
+// ranges. Pairs with later glyphs, e.g. of a CJK range, aren't kerned.
+inline constexpr std::uint32_t font_pack_magic   = 0x50465854;  // "TXFP"
+inline constexpr std::uint32_t font_pack_version = 1;
+inline constexpr std::size_t   font_pack_kerned_glyphs = 2048;
+
+struct font_pack_header {
+    std::uint32_t magic{font_pack_magic};
+    std::uint32_t version{font_pack_version};
+    std::uint32_t size{0};
+    std::uint32_t render_mode{0};  // text_render_mode
+    double        scale{1.0};
+    std::uint32_t kerning_count{0};
+    std::uint32_t reserved{0};
+};
+static_assert(sizeof(font_pack_header) == 32);
+
+using font_pack_kerning = glyph_cache_kerning;
+
+class font_pack {
+public:
+    font_pack(mapped_file_ref_t file);
+    ~font_pack() = default;
+
+    auto header() const -> font_pack_header const& { return *m_header; }
+    auto kerning() const -> std::span<font_pack_kerning const> { return m_kerning; }
+    // Pair kerning in 26.6 pixels, 0 for pairs that weren't baked.
+    auto kerning(std::uint32_t const& left, std::uint32_t const& right) const -> std::int64_t { return find_kerning(m_kerning, left, right); }
+    auto cache() const -> glyph_cache_ref_t const& { return m_cache; }
+
+private:
+    mapped_file_ref_t                  m_file;
+    font_pack_header const*            m_header{nullptr};
+    std::span<font_pack_kerning const> m_kerning{};
+    glyph_cache_ref_t                  m_cache{nullptr};
+};
+
+using font_pack_ref_t = ref<font_pack>;
+
+// Throws when the file is missing or malformed.
+auto open_font_pack(std::filesystem::path const& filename) -> font_pack_ref_t;
+// Kerning pairs must be sorted. Written to a temporary file and renamed like the glyph cache.
+auto write_font_pack(std::filesystem::path const& filename, font_pack_header const& header,
+                     std::vector<font_pack_kerning> const& kerning,
+                     glyph_cache_header const& cache_header,
+                     std::vector<glyph_cache_record> const& records,
+                     std::vector<std::uint8_t> const& bitmaps,
+                     image_u8 const& atlas) -> bool;
+} // namespace txt
+
+#endif  // TXT_FONT_PACK_HPP
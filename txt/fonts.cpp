@@ -1,126 +1,866 @@
 #include "fonts.hpp"
+#include "packer.hpp"
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <thread>
+#include <future>
+#include <optional>
 
 namespace txt {
-typeface::typeface(typeface_props const& props, font_family_weak_t const& font_family)
+// Spawning a worker opens its own library and face, it is not worth it for small ranges.
+// Generating an MSDF costs about a hundred times more than rasterizing, a few glyphs already pay off.
+static constexpr std::size_t min_glyphs_per_worker      = 64;
+static constexpr std::size_t min_msdf_glyphs_per_worker = 8;
+// Kerning pairs are stored in the glyph cache by asking every pair, larger caches only record whether the
+// face kerns at all.
+static constexpr std::size_t max_kerned_cache_glyphs = 512;
+
+static auto worker_count(std::uint32_t const& requested, std::size_t const& glyphs, std::size_t const& min_glyphs) -> std::size_t {
+#ifdef __EMSCRIPTEN__
+    (void)requested;
+    (void)glyphs;
+    (void)min_glyphs;
+    return 1;  // Not linked with pthread support, std::thread can't be created.
+#else
+    auto count = requested == 0 ? std::size_t(std::thread::hardware_concurrency()) : std::size_t(requested);
+    count = std::min(count, glyphs / min_glyphs);
+    return std::max(count, std::size_t(1));
+#endif
+}
+
+// Bitmap is written to the arena, the returned glyph points into it.
+static auto rasterize_glyph(FT_Face face, FT_Library library, FT_Bitmap* bitmap, std::int32_t flags, std::size_t channels, std::uint32_t code, bitmap_arena& arena) -> std::optional<glyph> {
+    auto const index = FT_Get_Char_Index(face, code);
+    if (index == 0) return std::nullopt;
+    if (FT_Load_Glyph(face, index, flags)) return std::nullopt;
+
+    auto const width     = face->glyph->bitmap.width / static_cast<std::uint32_t>(channels);
+    auto const height    = face->glyph->bitmap.rows;
+    auto const left      = face->glyph->bitmap_left;
+    auto const top       = face->glyph->bitmap_top;
+    auto const advance_x = face->glyph->advance.x;
+    auto const advance_y = face->size->metrics.height;
+
+    // Convert to one byte alignment
+    FT_Bitmap_Convert(library, &face->glyph->bitmap, bitmap, 1);
+    return glyph{
+        .codepoint    = code,
+        .bearing_left = left,
+        .bearing_top  = top,
+        .advance_x    = advance_x,
+        .advance_y    = advance_y,
+        .width        = width,
+        .height       = height,
+        .offset       = arena.allocate(bitmap->buffer, std::size_t(width) * height * channels),
+    };
+}
+
+// MSDF from the glyph outline, FreeType only loads it. Bitmap fonts have no outline to generate from.
+static auto generate_glyph(FT_Face face, msdf_generator& generator, std::int32_t flags, std::uint32_t code, bitmap_arena& arena) -> std::optional<glyph> {
+    auto const index = FT_Get_Char_Index(face, code);
+    if (index == 0) return std::nullopt;
+    if (FT_Load_Glyph(face, index, flags)) return std::nullopt;
+    if (face->glyph->format != FT_GLYPH_FORMAT_OUTLINE) return std::nullopt;
+    if (!generator.generate(&face->glyph->outline)) return std::nullopt;
+
+    auto const& pixels = generator.pixels();
+    return glyph{
+        .codepoint    = code,
+        .bearing_left = generator.left(),
+        .bearing_top  = generator.top(),
+        .advance_x    = face->glyph->advance.x,
+        .advance_y    = face->size->metrics.height,
+        .width        = generator.width(),
+        .height       = generator.height(),
+        .offset       = arena.allocate(pixels.data(), pixels.size()),
+    };
+}
+
+// FreeType objects are not thread safe, every worker owns a library, face and scratch bitmap.
+// The face is created from the shared file mapping, the file is not read again.
+class raster_worker {
+public:
+    raster_worker(mapped_file const& file, std::int32_t face_index, std::uint32_t pixel_size, text_render_mode mode) : m_mode(mode) {
+        if (FT_Init_FreeType(&m_library))
+            throw std::runtime_error("Failed to initialise FreeType library for raster worker");
+        FT_Bitmap_Init(&m_bitmap);
+        if (mode == text_render_mode::subpixel)
+            FT_Library_SetLcdFilter(m_library, FT_LCD_FILTER_DEFAULT);
+        if (FT_New_Memory_Face(m_library, file.data(), FT_Long(file.size()), face_index, &m_face)) {
+            FT_Done_FreeType(m_library);
+            throw std::runtime_error(fmt::format("Raster worker failed to load font '{}'.", file.filename().string()));
+        }
+        FT_Set_Pixel_Sizes(m_face, 0, pixel_size);
+    }
+    ~raster_worker() {
+        FT_Bitmap_Done(m_library, &m_bitmap);
+        FT_Done_Face(m_face);
+        FT_Done_FreeType(m_library);
+    }
+    raster_worker(raster_worker const&) = delete;
+    auto operator=(raster_worker const&) -> raster_worker& = delete;
+
+    // Rasterize every stride-th codepoint starting from offset into the worker's own arena.
+    auto run(std::vector<std::uint32_t> const& codes, std::size_t offset, std::size_t stride, std::int32_t flags, std::size_t channels) -> std::vector<glyph> {
+        std::vector<glyph> glyphs{};
+        glyphs.reserve(codes.size() / stride + 1);
+        for (auto i = offset; i < codes.size(); i += stride) {
+            auto gh = m_mode == text_render_mode::msdf
+                ? generate_glyph(m_face, m_msdf, flags, codes[i], m_arena)
+                : rasterize_glyph(m_face, m_library, &m_bitmap, flags, channels, codes[i], m_arena);
+            if (gh.has_value()) glyphs.push_back(*gh);
+        }
+        return glyphs;
+    }
+    auto arena() -> bitmap_arena& { return m_arena; }
+    auto has_kerning() const -> bool { return FT_HAS_KERNING(m_face); }
+
+private:
+    text_render_mode m_mode;
+    FT_Library       m_library{nullptr};
+    FT_Face          m_face{nullptr};
+    FT_Bitmap        m_bitmap{};
+    msdf_generator   m_msdf{};
+    bitmap_arena     m_arena{};
+};
+
+#ifndef __EMSCRIPTEN__
+static constexpr auto background_policy = std::launch::async;
+#else
+static constexpr auto background_policy = std::launch::deferred;  // No threads, runs when the frame adopts it
+#endif
+
+static auto render_flags(text_render_mode mode) -> std::int32_t {
+    if (mode == text_render_mode::sdf) return FT_LOAD_RENDER | FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
+    if (mode == text_render_mode::msdf) return FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING;  // Generated from the outline, FreeType doesn't render.
+    if (mode == text_render_mode::subpixel) return FT_LOAD_RENDER | FT_LOAD_TARGET_(FT_RENDER_MODE_LCD);
+    return FT_LOAD_RENDER;
+}
+static auto render_channels(text_render_mode mode) -> std::size_t {
+    return mode == text_render_mode::subpixel || mode == text_render_mode::msdf ? 3 : 1;
+}
+static auto raster_pixel_size(text_render_mode mode, std::uint32_t size, double scale) -> std::uint32_t {
+    if (mode == text_render_mode::sdf) return std::max(size, sdf_pixel_size);
+    if (mode == text_render_mode::msdf) return msdf_pixel_size;
+    return std::uint32_t(double(size) * scale);
+}
+
+static auto glyph_cache_path(typeface_props const& props) -> std::filesystem::path {
+    // Named after the settings only, a changed font file overwrites its stale cache.
+    auto hash = fnv1a(props.filename.data(), props.filename.size());
+    hash = fnv1a_value(props.face_index, hash);
+    hash = fnv1a_value(props.size, hash);
+    hash = fnv1a_value(props.scale, hash);
+    hash = fnv1a_value(props.render_mode, hash);
+    hash = fnv1a_value(props.ranges, hash);
+    return std::filesystem::path{props.cache} / fmt::format("{:016x}.glyphs", hash);
+}
+// The font file itself is matched by its stamp and hash in the header, see open_glyph_cache.
+static auto glyph_cache_key(typeface_props const& props) -> std::uint64_t {
+    constexpr std::array<std::int32_t, 3> ft_version{FREETYPE_MAJOR, FREETYPE_MINOR, FREETYPE_PATCH};
+    auto key = fnv1a_value(ft_version);
+    key = fnv1a(props.filename.data(), props.filename.size(), key);
+    key = fnv1a_value(props.face_index, key);
+    key = fnv1a_value(props.size, key);
+    key = fnv1a_value(props.scale, key);
+    key = fnv1a_value(props.render_mode, key);
+    key = fnv1a_value(props.ranges, key);
+    return key;
+}
+
+// Codepoints are interleaved between workers so expensive blocks, e.g. CJK, are spread evenly. With one
+// worker everything is rendered on the calling thread. Only reads the mapped file, safe off the render thread.
+static auto rasterize_face(mapped_file const& file, std::int32_t face_index, std::uint32_t pixel_size, text_render_mode mode,
+                           std::int32_t flags, std::size_t channels, std::vector<std::uint32_t> const& codes, std::size_t workers) -> raster_set {
+    raster_set set{};
+    if (codes.empty()) return set;
+    if (workers == 1) {
+        raster_worker worker{file, face_index, pixel_size, mode};
+        set.glyphs = worker.run(codes, 0, 1, flags, channels);
+        set.arena  = std::move(worker.arena());
+        set.has_kerning = worker.has_kerning();
+        return set;
+    }
+    auto has_kerning = false;  // Written by the first worker, read after its job is done
+    std::vector<std::future<std::pair<std::vector<glyph>, bitmap_arena>>> jobs{};
+    jobs.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        jobs.push_back(std::async(std::launch::async, [&, i] {
+            raster_worker worker{file, face_index, pixel_size, mode};
+            if (i == 0) has_kerning = worker.has_kerning();
+            auto glyphs = worker.run(codes, i, workers, flags, channels);
+            return std::pair{std::move(glyphs), std::move(worker.arena())};
+        }));
+    }
+    for (auto& job : jobs) {
+        auto const [glyphs, arena] = job.get();
+        auto const base = set.arena.append(arena);
+        for (auto gh : glyphs) {
+            gh.offset += base;
+            set.glyphs.push_back(gh);
+        }
+    }
+    set.has_kerning = has_kerning;
+    return set;
+}
+
+// Everything a typeface load does that doesn't need the manager: the file is mapped, then either the
+// glyph cache opens or the ranges are rasterized. Runs on a worker for font_manager::load_async.
+static auto preload_typeface(typeface_props const& props) -> typeface_preload {
+    if (!std::filesystem::exists(props.filename))
+        throw std::runtime_error(fmt::format("Font file path '{}' does not exist!", props.filename));
+    typeface_preload preload{};
+    preload.file = make_mapped_file(props.filename);
+    if (!props.cache.empty()) {
+        preload.cache = open_glyph_cache(glyph_cache_path(props), glyph_cache_key(props), props.filename);
+        if (preload.cache != nullptr && preload.cache->header().channels == render_channels(props.render_mode)) return preload;
+        preload.cache = nullptr;
+    }
+    auto const& range = props.ranges;
+    std::vector<std::uint32_t> codes{};
+    codes.reserve(range[1] > range[0] ? range[1] - range[0] : 0);
+    for (std::uint32_t code = range[0]; code < range[1]; ++code)
+        codes.push_back(code);
+    auto const mode = props.render_mode;
+    auto const min_glyphs = mode == text_render_mode::msdf ? min_msdf_glyphs_per_worker : min_glyphs_per_worker;
+    auto const workers = worker_count(props.threads, codes.size(), min_glyphs);
+    auto const size = raster_pixel_size(mode, props.size, props.scale);
+    preload.glyphs = rasterize_face(*preload.file, props.face_index, size, mode, render_flags(mode), render_channels(mode), codes, workers);
+    return preload;
+}
+
+auto glyph_metrics::push(glyph const& gh) -> void {
+    bearing_left.push_back(gh.bearing_left);
+    bearing_top.push_back(gh.bearing_top);
+    width.push_back(std::int32_t(gh.width));
+    height.push_back(std::int32_t(gh.height));
+    advance_x.push_back(gh.advance_x);
+}
+auto glyph_metrics::set(std::size_t index, glyph const& gh) -> void {
+    bearing_left[index] = gh.bearing_left;
+    bearing_top[index]  = gh.bearing_top;
+    width[index]        = std::int32_t(gh.width);
+    height[index]       = std::int32_t(gh.height);
+    advance_x[index]    = gh.advance_x;
+}
+auto glyph_metrics::clear() -> void {
+    bearing_left.clear();
+    bearing_top.clear();
+    width.clear();
+    height.clear();
+    advance_x.clear();
+}
+
+font_face::font_face(FT_Library library, mapped_file_ref_t const& file, std::int32_t index)
+    : m_file(file)
+    , m_index(index) {
+    auto const ft_ec = FT_New_Memory_Face(library, m_file->data(), FT_Long(m_file->size()), m_index, &m_face);
+    if (ft_ec == FT_Err_Unknown_File_Format)
+        throw std::runtime_error(fmt::format("Font file path '{}' have an unknown file format.", m_file->filename().string()));
+    else if (ft_ec == FT_Err_Invalid_Argument)
+        throw std::runtime_error(fmt::format("Font file '{}' has no face with index {}.", m_file->filename().string(), m_index));
+    else if (ft_ec)
+        throw std::runtime_error(fmt::format("Error loading font '{}' file, error type not currently supported.", m_file->filename().string()));
+    else if (m_face == nullptr)
+        throw std::runtime_error("Error createing FT_Face!");
+}
+font_face::~font_face() {
+    if (m_face != nullptr) FT_Done_Face(m_face);
+}
+auto font_face::coverage() -> coverage_set const& {
+    if (m_has_coverage || m_face == nullptr) return m_coverage;
+    FT_UInt index = 0;
+    for (auto code = FT_Get_First_Char(m_face, &index); index != 0; code = FT_Get_Next_Char(m_face, code, &index))
+        m_coverage.insert(std::uint32_t(code));
+    m_has_coverage = true;
+    return m_coverage;
+}
+auto font_face::new_size() -> FT_Size {
+    FT_Size size{nullptr};
+    if (FT_New_Size(m_face, &size))
+        throw std::runtime_error(fmt::format("Failed to create size for font '{}'.", m_file->filename().string()));
+    return size;
+}
+auto font_face::done_size(FT_Size size) -> void {
+    if (m_face != nullptr && size != nullptr) FT_Done_Size(size);
+}
+
+typeface::typeface(typeface_props const& props, font_family_weak_t const& font_family, std::optional<typeface_preload> preload)
     : m_filename(props.filename)
+    , m_face_index(props.face_index)
     , m_family(font_family)
     , m_size(props.size)
     , m_mode(props.render_mode)
     , m_family_name(props.family)
-    , m_scale(props.scale) {
-    load(props.ranges);
+    , m_scale(props.scale)
+    , m_threads(props.threads)
+    , m_atlas_budget(props.atlas_budget)
+    , m_ranges(props.ranges)
+    , m_cache_dir(props.cache) {
+    if (preload.has_value())
+        adopt(std::move(*preload));
+    else
+        load(props.ranges);
+    m_pinned = m_glyphs.size();
+    auto const slot = m_max_glyph_size + atlas_padding;
+    if (m_atlas_budget != 0 && m_atlas_budget < slot * slot * m_channels)
+        throw std::runtime_error(fmt::format("Atlas budget of {} bytes for '{}' can't hold a glyph of {} pixels!", m_atlas_budget, m_family_name, m_max_glyph_size));
+}
+typeface::~typeface() {
+    if (m_face != nullptr) m_face->done_size(m_ft_size);
+    for (auto const& fb : m_fallbacks) {
+        if (fb.face != nullptr) fb.face->done_size(fb.size);
+    }
+}
+
+auto typeface::store_cache(image_u8 const& atlas, std::size_t pages, std::vector<glm::vec3> const& uvs, std::size_t padding) -> void {
+    m_cache_stale = false;
+    if (m_cache_dir.empty()) return;
+    if (uvs.size() < m_glyphs.size()) return;  // Atlas is behind the glyphs, nothing consistent to store.
+    if (!m_free.empty()) return;               // Evicted indices leave holes, records are dense.
+
+    // Glyphs rendered from fallbacks are left out. The cache is opened before any fallback is added and
+    // isn't keyed on the chain, which may be different by the next start. A chain means the face is open.
+    if (!m_fallbacks.empty()) open_face();
+    std::vector<glyph_cache_record> records{};
+    records.reserve(m_glyphs.size());
+    for (std::size_t i = 0; i < m_glyphs.size(); ++i) {
+        auto const& gh = m_glyphs[i];
+        if (!m_fallbacks.empty() && !m_face->coverage().contains(gh.codepoint)) continue;
+        records.push_back({
+            .codepoint     = gh.codepoint,
+            .bearing_left  = gh.bearing_left,
+            .bearing_top   = gh.bearing_top,
+            .width         = gh.width,
+            .height        = gh.height,
+            .uv_x          = uvs[i].x,
+            .uv_y          = uvs[i].y,
+            .page          = std::uint32_t(uvs[i].z),
+            .advance_x     = gh.advance_x,
+            .advance_y     = gh.advance_y,
+            .bitmap_offset = gh.offset,
+        });
+    }
+
+    // Only the primary face kerns. Glyphs all from the cache keep its pairs, the face is only opened to
+    // compute them.
+    std::vector<glyph_cache_kerning> kerning{};
+    std::uint32_t flags = m_has_kerning ? glyph_cache_has_kerning : 0;
+    if (m_face == nullptr && m_cache != nullptr) {
+        flags = m_cache->header().flags;
+        kerning.assign(std::begin(m_cache->kerning()), std::end(m_cache->kerning()));
+    } else if (m_has_kerning && records.size() <= max_kerned_cache_glyphs) {
+        open_face();
+        flags |= glyph_cache_all_kerning;
+        for (auto const& left : records) {
+            for (auto const& right : records) {
+                if (auto const x = kerning_of(left.codepoint, right.codepoint); x != 0)
+                    kerning.push_back({left.codepoint, right.codepoint, x});
+            }
+        }
+        std::sort(std::begin(kerning), std::end(kerning), [](auto const& a, auto const& b) {
+            return a.left != b.left ? a.left < b.left : a.right < b.right;
+        });
+    }
+
+    // The only time the font file is hashed, starts match it by its stamp.
+    if (m_file == nullptr) m_file = retrieve_manager()->map_file(m_filename);
+    auto const stamp = stamp_font_file(m_filename);
+    glyph_cache_header const header{
+        .key           = cache_key(),
+        .channels      = std::uint32_t(m_channels),
+        .glyph_count   = std::uint32_t(records.size()),
+        .atlas_width   = std::uint32_t(atlas.width()),
+        .atlas_height  = std::uint32_t(atlas.height()),
+        .padding       = std::uint32_t(padding),
+        .pages         = std::uint32_t(pages),
+        .bitmap_bytes  = m_arena.bytes(),
+        .kerning_count = std::uint32_t(kerning.size()),
+        .flags         = flags,
+        .font_bytes    = stamp.bytes,
+        .font_time     = stamp.time,
+        .font_hash     = fnv1a(m_file->data(), m_file->size()),
+    };
+    write_glyph_cache(cache_path(), header, records, kerning, m_arena.buffer(), atlas);
+}
+
+auto typeface::layout_scale() const -> float {
+    if (m_mode == text_render_mode::raster) return 1.0f;
+    if (is_distance_field(m_mode)) return float(m_size) / float(pixel_size());
+    return float(1.0 / m_scale);
 }
 
 auto typeface::set_size(std::uint32_t const& size) -> void {
     m_size = size;
-    FT_Set_Pixel_Sizes(m_ft_face, 0, std::uint32_t(double(m_size) * m_scale));
+    if (m_face != nullptr) activate_size();
 }
 auto typeface::set_scale(double const& scale) -> void {
     m_scale = scale;
-    FT_Set_Pixel_Sizes(m_ft_face, 0, std::uint32_t(double(m_size) * m_scale));
+    if (m_face != nullptr) activate_size();
 }
 auto typeface::set_mode(text_render_mode const& mode) -> void {
     m_mode = mode;
 }
 
+auto typeface::fallbacks() const -> std::vector<typeface_ref_t> {
+    std::vector<typeface_ref_t> typefaces{};
+    typefaces.reserve(m_fallbacks.size());
+    for (auto const& fb : m_fallbacks) {
+        if (auto tf = fb.typeface.lock(); tf != nullptr) typefaces.push_back(std::move(tf));
+    }
+    return typefaces;
+}
+auto typeface::add_fallback(typeface_ref_t const& other) -> void {
+    if (other == nullptr || other.get() == this) return;
+    m_fallbacks.push_back({.typeface = other, .filename = other->filename(), .face_index = other->face_index()});
+    ++m_generation;
+    // Codepoints that resolved to space may be covered now.
+    for (auto const& code : m_missing)
+        m_table.erase(code);
+    m_missing.clear();
+}
+
 auto typeface::reload() -> void {
+    if (m_pack != nullptr) return;  // Baked glyphs stay as they are, drawn scaled
+    // Glyphs already match the settings, e.g. an SDF typeface after a scale change.
+    if (m_raster_size == pixel_size() && m_raster_mode == m_mode) return;
+    m_raster_size = pixel_size();
+    m_raster_mode = m_mode;
+    ++m_generation;
+
     auto const [ft_library, ft_bitmap] = retrieve_ft();
     init_rendering_mode(ft_library);
-    FT_Set_Pixel_Sizes(m_ft_face, 0, std::uint32_t(double(m_size) * m_scale));
+    open_face();
+    activate_size();
 
+    // Cached atlas was rendered with the old settings, a new one is written after the atlas is rebuilt.
+    m_cache       = nullptr;
+    m_cache_stale = !m_cache_dir.empty();
     m_max_glyph_size = 0;
-    for (auto const& [code, glyph] : m_glyphs)
-        load_glyph(code, ft_library, ft_bitmap);
+    // Every bitmap is rendered again, start from an empty arena. A glyph that fails to render stays empty.
+    // Evicted indices stay free.
+    auto const previous_bytes = m_arena.bytes() - m_arena_garbage;
+    m_arena.clear();
+    m_arena.reserve(previous_bytes);
+    m_arena_garbage = 0;
+    std::vector<bool> is_free(m_glyphs.size(), false);
+    for (auto const& index : m_free)
+        is_free[index] = true;
+    std::vector<std::uint32_t> codes{};
+    codes.reserve(m_glyphs.size());
+    for (std::size_t i = 0; i < m_glyphs.size(); ++i) {
+        auto& gh = m_glyphs[i];
+        if (!is_free[i]) codes.push_back(gh.codepoint);
+        gh.width  = 0;
+        gh.height = 0;
+        gh.offset = 0;
+    }
+    load_glyphs(codes, ft_library, ft_bitmap);
+}
+auto typeface::rescale(double const& scale) -> void {
+    if (m_pack != nullptr) return;
+    m_rescale_to = scale;
+    if (m_rescale.valid()) return;  // Started again at the latest scale once the running one finishes
+    if (scale == m_scale) return;
+    if (pixel_size(scale) == m_raster_size && m_raster_mode == m_mode) {
+        m_scale = scale;  // Glyphs don't depend on it, e.g. SDF
+        return;
+    }
+    start_rescale(scale);
+}
+auto typeface::start_rescale(double const& scale) -> void {
+    // Sort the loaded codepoints by the face that has them, on this thread, coverage and faces are lazy.
+    open_face();
+    struct source {
+        mapped_file_ref_t          file;
+        std::int32_t               face_index;
+        std::vector<std::uint32_t> codes{};
+    };
+    std::vector<source> sources{};
+    sources.push_back({m_file, m_face_index});
+    for (auto& fb : m_fallbacks) {
+        if (fb.face == nullptr) {
+            fb.face = retrieve_manager()->acquire_face(fb.filename, fb.face_index);
+            fb.size = fb.face->new_size();
+            FT_Activate_Size(fb.size);
+            FT_Set_Pixel_Sizes(fb.face->face(), 0, pixel_size());
+        }
+        sources.push_back({fb.face->file(), fb.face->index()});
+    }
+    for (std::uint32_t i = 0; i < m_glyphs.size(); ++i) {
+        auto const code = m_glyphs[i].codepoint;
+        if (m_table.find(code) != i) continue;  // Evicted
+        if (m_fallbacks.empty() || m_face->coverage().contains(code)) {
+            sources[0].codes.push_back(code);
+            continue;
+        }
+        for (std::size_t j = 0; j < m_fallbacks.size(); ++j) {
+            if (!m_fallbacks[j].face->coverage().contains(code)) continue;
+            sources[j + 1].codes.push_back(code);
+            break;
+        }
+    }
+
+    auto const size = pixel_size(scale);
+    auto const min_glyphs = m_mode == text_render_mode::msdf ? min_msdf_glyphs_per_worker : min_glyphs_per_worker;
+    auto const workers = worker_count(m_threads, sources[0].codes.size(), min_glyphs);
+
+    // Everything the job needs is copied, the typeface keeps drawing and loading glyphs meanwhile.
+    m_rescale_scale = scale;
+    m_rescale = std::async(background_policy, [sources = std::move(sources), size, workers, mode = m_mode, flags = m_flags, channels = m_channels] {
+        raster_set result{};
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            auto const& src = sources[i];
+            auto set = rasterize_face(*src.file, src.face_index, size, mode, flags, channels, src.codes, i == 0 ? workers : 1);
+            auto const base = result.arena.append(set.arena);
+            for (auto gh : set.glyphs) {
+                gh.offset += base;
+                result.glyphs.push_back(gh);
+            }
+        }
+        return result;
+    });
+}
+auto typeface::finish_rescale() -> bool {
+    if (!m_rescale.valid()) return false;
+    if (m_rescale.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) return false;
+    auto set = m_rescale.get();
+    if (m_rescale_scale != m_rescale_to) {
+        // Scale changed again while rendering, throw these away.
+        rescale(m_rescale_to);
+        return false;
+    }
+
+    m_scale       = m_rescale_scale;
+    m_raster_size = pixel_size();
+    ++m_generation;
+    activate_size();
+    m_cache       = nullptr;
+    m_cache_stale = !m_cache_dir.empty();
+    m_max_glyph_size = 0;
+    m_arena = std::move(set.arena);
+    m_arena_garbage = 0;
+
+    // Indices stay as they are, glyphs are matched by codepoint. Glyphs evicted meanwhile are dropped.
+    std::vector<bool> done(m_glyphs.size(), false);
+    for (auto const& gh : set.glyphs) {
+        auto const index = m_table.find(gh.codepoint);
+        if (index == glyph_table::npos || m_glyphs[index].codepoint != gh.codepoint) continue;
+        m_glyphs[index] = gh;
+        m_metrics.set(index, gh);
+        m_max_glyph_size = std::max(m_max_glyph_size, std::size_t(std::max(gh.width, gh.height)));
+        done[index] = true;
+    }
+    for (auto const& index : m_free)
+        done[index] = true;
+    // Loaded while the workers ran, or failed to render there, rendered now at the new size.
+    for (std::uint32_t i = 0; i < m_glyphs.size(); ++i) {
+        if (done[i]) continue;
+        auto& gh  = m_glyphs[i];
+        gh.width  = 0;
+        gh.height = 0;
+        gh.offset = 0;
+        m_metrics.set(i, gh);
+        if (m_table.find(gh.codepoint) == i) load_glyph(gh.codepoint);
+    }
+    return true;
 }
 auto typeface::query(std::uint32_t const& code) -> glyph const& {
-    auto it = m_glyphs.find(code);
-    if (it == std::end(m_glyphs)) {
-        load_glyph(code);
-        it = m_glyphs.find(code);
-        if (it == std::end(m_glyphs)) return m_glyphs.at(' ');
+    return m_glyphs[index(code)];
+}
+auto typeface::evict(std::uint32_t const& index) -> bool {
+    if (index < m_pinned || index >= m_glyphs.size()) return false;
+    auto& gh = m_glyphs[index];
+    if (m_table.find(gh.codepoint) != index) return false;  // Already evicted
+    m_table.erase(gh.codepoint);
+    // Missing codepoints alias space, they'd draw whatever glyph gets the index next. Looked up again instead.
+    if (gh.codepoint == ' ') {
+        for (auto const& code : m_missing)
+            m_table.erase(code);
+        m_missing.clear();
     }
-    return it->second;
+    m_arena_garbage += std::size_t(gh.width) * gh.height * m_channels;
+    gh = glyph{};
+    m_metrics.set(index, gh);
+    m_free.push_back(index);
+    ++m_generation;
+    // Compact once half the arena is dead, the cost is spread over as many evictions as bytes moved.
+    if (m_arena_garbage * 2 > m_arena.bytes()) compact_arena();
+    return true;
+}
+auto typeface::has_kerning() -> bool {
+    if (m_pack != nullptr) return !m_pack->kerning().empty();
+    open_face();
+    return m_has_kerning;
+}
+auto typeface::kerning(std::uint32_t const& left, std::uint32_t const& right) -> std::int64_t {
+    if (m_pack != nullptr) return m_pack->kerning(left, right);
+    // Until a glyph outside the cache is loaded every codepoint is one of its records, the face stays closed.
+    if (m_face == nullptr && m_cache != nullptr) {
+        auto const flags = m_cache->header().flags;
+        if ((flags & glyph_cache_has_kerning) == 0) return 0;
+        if ((flags & glyph_cache_all_kerning) != 0) return m_cache->kerning(left, right);
+    }
+    open_face();
+    return kerning_of(left, right);
+}
+auto typeface::kerning_of(std::uint32_t const& left, std::uint32_t const& right) -> std::int64_t {
+    if (!m_has_kerning) return 0;
+    auto const face  = m_face->face();
+    auto const first = FT_Get_Char_Index(face, left);
+    auto const second = FT_Get_Char_Index(face, right);
+    if (first == 0 || second == 0) return 0;
+    // Pixel fonts stay on the grid, everything else keeps the fractional part.
+    auto const mode = m_mode == text_render_mode::raster ? FT_KERNING_DEFAULT : FT_KERNING_UNFITTED;
+    FT_Vector delta{};
+    FT_Activate_Size(m_ft_size);
+    if (FT_Get_Kerning(face, first, second, mode, &delta)) return 0;
+    return delta.x;
 }
+auto typeface::load_index(std::uint32_t const& code) -> std::uint32_t {
+    load_glyph(code);
+    auto const i = m_table.find(code);
+    if (i != glyph_table::npos) return i;
 
-auto typeface::retrieve_ft() -> std::pair<FT_Library, FT_Bitmap*> {
+    // Remember the miss as an alias of space, the face is not asked again for this codepoint. Space may
+    // be outside the preloaded ranges or evicted.
+    if (m_table.find(' ') == glyph_table::npos) load_glyph(' ');
+    auto const space = m_table.find(' ');
+    if (space == glyph_table::npos)
+        throw std::runtime_error(fmt::format("Typeface '{}' has no glyph for U+{:04X} nor a space to fall back on!", m_family_name, code));
+    m_table.insert(code, space);
+    m_missing.push_back(code);
+    return space;
+}
+
+auto typeface::compact_arena() -> void {
+    bitmap_arena arena{};
+    arena.reserve(m_arena.bytes() - m_arena_garbage);
+    for (auto& gh : m_glyphs) {
+        auto const bytes = std::size_t(gh.width) * gh.height * m_channels;
+        gh.offset = bytes == 0 ? 0 : arena.allocate(m_arena.data(gh.offset), bytes);
+    }
+    m_arena = std::move(arena);
+    m_arena_garbage = 0;
+}
+
+auto typeface::retrieve_manager() -> font_manager_ref_t {
     // Check pointer expirations from weak ptr. We make sure that the object we have is still alive.
     if (m_family.expired()) throw std::runtime_error("Font family has expired!");
     auto const family = m_family.lock();
     if (family->manager().expired()) throw std::runtime_error("Font manager has expired!");
-    auto const manager = family->manager().lock();
+    return family->manager().lock();
+}
+auto typeface::retrieve_ft() -> std::pair<FT_Library, FT_Bitmap*> {
+    auto const manager = retrieve_manager();
     auto const ft_library = manager->ft_library();
     auto const ft_bitmap  = manager->ft_bitmap();
     return {ft_library, ft_bitmap};
 }
 
 auto typeface::init_rendering_mode(FT_Library library) -> void {
-    m_channels = 1;
-    m_flags    = FT_LOAD_RENDER;
-    if (m_mode == text_render_mode::raster) {
-        // Do nothing, we render as usual
-    } else if (m_mode == text_render_mode::sdf) {
-        m_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_SDF);
-    } else if (m_mode == text_render_mode::subpixel) {
-        m_channels = 3;  // Set image channel to RGB for subpixel rendering.
-        m_flags |= FT_LOAD_TARGET_(FT_RENDER_MODE_LCD);
+    m_channels = render_channels(m_mode);
+    m_flags    = render_flags(m_mode);
+    if (m_mode == text_render_mode::subpixel)
         FT_Library_SetLcdFilter(library, FT_LCD_FILTER_DEFAULT);
+}
+
+auto typeface::open_face() -> void {
+    if (m_face != nullptr) return;
+    m_face    = retrieve_manager()->acquire_face(m_filename, m_face_index);
+    m_file    = m_face->file();
+    m_ft_size = m_face->new_size();
+    m_has_kerning = FT_HAS_KERNING(m_face->face());
+    activate_size();
+}
+auto typeface::pixel_size(double const& scale) const -> std::uint32_t {
+    return raster_pixel_size(m_mode, m_size, scale);
+}
+auto typeface::activate_size() -> void {
+    // Faces are shared, select this typeface's size before anything is loaded from them.
+    for (auto const& fb : m_fallbacks) {
+        if (fb.face == nullptr) continue;
+        FT_Activate_Size(fb.size);
+        FT_Set_Pixel_Sizes(fb.face->face(), 0, pixel_size());
+    }
+    FT_Activate_Size(m_ft_size);
+    FT_Set_Pixel_Sizes(m_face->face(), 0, pixel_size());
+}
+
+auto typeface::settings() const -> typeface_props {
+    return {
+        .filename     = m_filename,
+        .face_index   = m_face_index,
+        .size         = m_size,
+        .family       = m_family_name,
+        .style        = {},
+        .render_mode  = m_mode,
+        .ranges       = m_ranges,
+        .scale        = m_scale,
+        .threads      = m_threads,
+        .cache        = m_cache_dir,
+        .atlas_budget = m_atlas_budget,
+    };
+}
+auto typeface::cache_path() const -> std::filesystem::path {
+    return glyph_cache_path(settings());
+}
+auto typeface::cache_key() const -> std::uint64_t {
+    return glyph_cache_key(settings());
+}
+auto typeface::load_cache() -> bool {
+    m_cache = open_glyph_cache(cache_path(), cache_key(), m_filename);
+    if (m_cache == nullptr || m_cache->header().channels != m_channels) {
+        m_cache = nullptr;
+        return false;
+    }
+    insert_cache();
+    return true;
+}
+auto typeface::insert_cache() -> void {
+    // All bitmaps are copied in one go, record offsets are relative to the start of the blob.
+    auto const base = m_arena.allocate(m_cache->bitmaps(), m_cache->header().bitmap_bytes);
+    for (auto const& record : m_cache->records()) {
+        insert_glyph({
+            .codepoint    = record.codepoint,
+            .bearing_left = record.bearing_left,
+            .bearing_top  = record.bearing_top,
+            .advance_x    = record.advance_x,
+            .advance_y    = record.advance_y,
+            .width        = record.width,
+            .height       = record.height,
+            .offset       = base + record.bitmap_offset,
+        });
     }
 }
 
 auto typeface::load(character_range_t const& range) -> void {
+    m_raster_size = pixel_size();
+    m_raster_mode = m_mode;
     auto const [ft_library, ft_bitmap] = retrieve_ft();
     init_rendering_mode(ft_library);
 
-    auto const ft_ec = FT_New_Face(ft_library, m_filename.c_str(), 0, &m_ft_face);
-    if (ft_ec == FT_Err_Unknown_File_Format)
-        throw std::runtime_error(fmt::format("Font file path '{}' have an unknown file format.", m_filename));
-    else if(ft_ec)
-        throw std::runtime_error(fmt::format("Error loading font '{}' file, error type not currently supported.", m_filename));
-    else if (m_ft_face == nullptr)
-        throw std::runtime_error("Error createing FT_Face!");
+    // Warm start, FreeType is only touched when a glyph outside the cache is queried.
+    if (!m_cache_dir.empty()) {
+        if (load_cache()) return;
+        m_cache_stale = true;
+    }
 
-    FT_Set_Pixel_Sizes(m_ft_face, 0, std::uint32_t(m_size * m_scale));
+    open_face();
     // Load initial character range
+    std::vector<std::uint32_t> codes{};
+    codes.reserve(range[1] > range[0] ? range[1] - range[0] : 0);
     for (std::uint32_t code = range[0]; code < range[1]; ++code)
-        load_glyph(code, ft_library, ft_bitmap);
+        codes.push_back(code);
+    load_glyphs(codes, ft_library, ft_bitmap);
+}
+auto typeface::adopt(typeface_preload preload) -> void {
+    m_raster_size = pixel_size();
+    m_raster_mode = m_mode;
+    auto const [ft_library, ft_bitmap] = retrieve_ft();
+    init_rendering_mode(ft_library);
+    m_file      = std::move(preload.file);
+    m_pack      = std::move(preload.pack);
+    if (preload.cache != nullptr) {
+        m_cache = std::move(preload.cache);
+        insert_cache();
+        return;
+    }
+    m_cache_stale = !m_cache_dir.empty();
+    m_has_kerning = preload.glyphs.has_kerning;
+    auto const base = m_arena.append(preload.glyphs.arena);
+    for (auto gh : preload.glyphs.glyphs) {
+        gh.offset += base;
+        insert_glyph(gh);
+    }
+}
+auto typeface::load_glyphs(std::vector<std::uint32_t> const& requested, FT_Library library, FT_Bitmap* bitmap) -> void {
+    // Workers only know the primary face, whatever it doesn't cover goes through the fallback chain here.
+    std::vector<std::uint32_t> covered{};
+    if (!m_fallbacks.empty()) {
+        open_face();
+        auto const& coverage = m_face->coverage();
+        covered.reserve(requested.size());
+        for (auto const& code : requested) {
+            if (coverage.contains(code))
+                covered.push_back(code);
+            else
+                load_glyph(code, library, bitmap);
+        }
+    }
+    auto const& codes = m_fallbacks.empty() ? requested : covered;
+
+    auto const min_glyphs = m_mode == text_render_mode::msdf ? min_msdf_glyphs_per_worker : min_glyphs_per_worker;
+    auto const workers = worker_count(m_threads, codes.size(), min_glyphs);
+    if (workers == 1) {
+        for (auto const& code : codes)
+            load_glyph(code, library, bitmap);
+        return;
+    }
+
+    auto const set  = rasterize_face(*m_file, m_face_index, pixel_size(), m_mode, m_flags, m_channels, codes, workers);
+    auto const base = m_arena.append(set.arena);
+    for (auto gh : set.glyphs) {
+        gh.offset += base;
+        insert_glyph(gh);
+    }
 }
 
 auto typeface::load_glyph(std::uint32_t const& code) -> void {
-    // Check pointer expirations from weak ptr. We make sure that the object we have is still alive.
-    if (m_family.expired()) throw std::runtime_error("Font family has expired!");
-    auto const family = m_family.lock();
-    if (family->manager().expired()) throw std::runtime_error("Font manager has expired!");
-    auto const manager = family->manager().lock();
-    auto const ft_library = manager->ft_library();
-    auto const ft_bitmap  = manager->ft_bitmap();
+    auto const [ft_library, ft_bitmap] = retrieve_ft();
     load_glyph(code, ft_library, ft_bitmap);
 }
 auto typeface::load_glyph(std::uint32_t const& code, FT_Library library, FT_Bitmap* bitmap) -> void {
-    auto const index = FT_Get_Char_Index(m_ft_face, code);
-    if (index == 0) return;
-    if (FT_Load_Glyph(m_ft_face, index, m_flags)) return;
-
-    auto const width     = m_ft_face->glyph->bitmap.width / static_cast<std::uint32_t>(m_channels);
-    auto const height    = m_ft_face->glyph->bitmap.rows;
-    auto const left      = m_ft_face->glyph->bitmap_left;
-    auto const top       = m_ft_face->glyph->bitmap_top;
-    auto const advance_x = m_ft_face->glyph->advance.x;
-    auto const advance_y = m_ft_face->size->metrics.height;
-
-    // Convert to one byte alignment
-    FT_Bitmap_Convert(library, &m_ft_face->glyph->bitmap, bitmap, 1);
-    m_glyphs.insert_or_assign(code, glyph{
-        .codepoint    = code,
-        .bearing_left = left,
-        .bearing_top  = top,
-        .advance_x    = advance_x,
-        .advance_y    = advance_y,
-        .bitmap       = make_image_u8(bitmap->buffer, width, height, m_channels),
-    });
-
-    auto const width_or_height = std::size_t(std::max(width, height));
+    std::optional<glyph> gh{};
+    // A pack has no outlines to render from, codepoints it doesn't have can only come from fallbacks.
+    if (m_pack == nullptr) {
+        open_face();
+        if (m_fallbacks.empty() || m_face->coverage().contains(code)) {
+            FT_Activate_Size(m_ft_size);
+            gh = render_glyph(m_face->face(), code, library, bitmap);
+        }
+    }
+    // The coverage bitsets decide which face has it, only that face is asked to render.
+    for (auto it = std::begin(m_fallbacks); !gh.has_value() && it != std::end(m_fallbacks); ++it) {
+        auto& fb = *it;
+        if (fb.face == nullptr) {
+            fb.face = retrieve_manager()->acquire_face(fb.filename, fb.face_index);
+            fb.size = fb.face->new_size();
+            FT_Activate_Size(fb.size);
+            FT_Set_Pixel_Sizes(fb.face->face(), 0, pixel_size());
+        }
+        if (!fb.face->coverage().contains(code)) continue;
+        FT_Activate_Size(fb.size);
+        gh = render_glyph(fb.face->face(), code, library, bitmap);
+    }
+    if (gh.has_value()) insert_glyph(*gh);
+}
+auto typeface::render_glyph(FT_Face face, std::uint32_t const& code, FT_Library library, FT_Bitmap* bitmap) -> std::optional<glyph> {
+    if (m_mode == text_render_mode::msdf)
+        return generate_glyph(face, m_msdf, m_flags, code, m_arena);
+    return rasterize_glyph(face, library, bitmap, m_flags, m_channels, code, m_arena);
+}
+auto typeface::insert_glyph(glyph const& gh) -> void {
+    auto const width_or_height = std::size_t(std::max(gh.width, gh.height));
     m_max_glyph_size = std::max(m_max_glyph_size, width_or_height);
+    auto const index = m_table.find(gh.codepoint);
+    if (index != glyph_table::npos && m_glyphs[index].codepoint == gh.codepoint) {
+        m_metrics.set(index, gh);
+        m_glyphs[index] = gh;
+        return;
+    }
+    if (!m_free.empty()) {
+        auto const free = m_free.back();
+        m_free.pop_back();
+        m_table.insert(gh.codepoint, free);
+        m_metrics.set(free, gh);
+        m_glyphs[free] = gh;
+        return;
+    }
+    m_table.insert(gh.codepoint, std::uint32_t(m_glyphs.size()));
+    m_metrics.push(gh);
+    m_glyphs.push_back(gh);
 }
 
 font_family::font_family(std::string const& name, font_manager_weak_t const& font_manager)
@@ -128,19 +868,18 @@ font_family::font_family(std::string const& name, font_manager_weak_t const& fon
     , m_manager(font_manager) { }
 
 auto font_family::reload() -> void {
-    // TODO: unload bitmap of the stale ones.
     for (auto& [style, tf] : m_typefaces)
         tf->reload();
 }
-auto font_family::add(typeface_props const& props) -> void {
+auto font_family::add(typeface_props const& props, std::optional<typeface_preload> preload) -> typeface_ref_t const& {
     auto const style_name = props.style;
     auto const it = m_typefaces.find(style_name);
     if (it != std::end(m_typefaces)) {
         it->second->reload();
-        return;  // Reload and return because style already exist!
+        return it->second;  // Reload and return because style already exist!
     }
-    auto tf = make_ref<txt::typeface>(props, shared_from_this());
-    m_typefaces.insert({style_name, tf});
+    auto tf = make_ref<txt::typeface>(props, shared_from_this(), std::move(preload));
+    return m_typefaces.insert({style_name, tf}).first->second;
 }
 auto font_family::typeface(std::string const& style) const -> typeface_ref_t const& {
     auto const it = m_typefaces.find(style);
@@ -155,6 +894,11 @@ font_manager::font_manager() {
     FT_Bitmap_Init(&m_bitmap);
 }
 font_manager::~font_manager() {
+    // Typefaces held outside the manager keep their face alive, it is released together with the library.
+    m_families.clear();
+    for (auto const& [key, face] : m_faces) {
+        if (auto const shared = face.lock(); shared != nullptr) shared->detach();
+    }
     FT_Bitmap_Done(m_library, &m_bitmap);
     FT_Done_FreeType(m_library);
 }
@@ -167,16 +911,93 @@ auto font_manager::reload() -> void {
 auto font_manager::load(typeface_props const& props) -> void {
     if (!std::filesystem::exists(props.filename))
         throw std::runtime_error(fmt::format("Font file path '{}' does not exist!", props.filename));
-    auto const family_name = props.family;
-    auto const family_it   = m_families.find(family_name);
-    font_family_ref_t family = nullptr;
-    if (family_it != std::end(m_families)) {
-        family = family_it->second;
-    } else {
-        family = make_ref<font_family>(family_name, shared_from_this());
-        m_families.insert({family_name, family});
-    }
-    family->add(props);
+    add_family(props.family)->add(props);
+}
+auto font_manager::load_pack(std::string const& filename, std::string const& family, std::string const& style) -> void {
+    auto pack = open_font_pack(filename);
+    auto const& header = pack->header();
+    typeface_props const props{
+        .filename    = filename,
+        .size        = header.size,
+        .family      = family,
+        .style       = style,
+        .render_mode = text_render_mode(header.render_mode),
+        .ranges      = {0, 0},
+        .scale       = header.scale,
+    };
+    add_family(family)->add(props, typeface_preload{.cache = pack->cache(), .pack = pack});
+}
+auto font_manager::load_async(typeface_props const& props) -> font_handle_ref_t {
+    auto handle = make_ref<font_handle>();
+    handle->m_props = props;
+    if (auto tf = find_loaded(props); tf != nullptr) {
+        handle->m_typeface = std::move(tf);
+        return handle;
+    }
+    handle->m_job   = std::async(background_policy, [props] { return preload_typeface(props); });
+    m_pending.push_back(handle);
+    return handle;
+}
+auto font_manager::adopt_loaded() -> std::vector<typeface_ref_t> {
+    std::vector<typeface_ref_t> adopted{};
+    for (auto it = std::begin(m_pending); it != std::end(m_pending);) {
+        auto& handle = *it;
+        auto& job    = handle->m_job;
+        // Deferred jobs have no thread to finish on, they run here.
+        if (job.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
+            ++it;
+            continue;
+        }
+        try {
+            auto preload = job.get();
+            auto const& props = handle->m_props;
+            // Loaded twice, or with load() meanwhile. add() would throw the preload away and reload.
+            if (auto tf = find_loaded(props); tf != nullptr) {
+                handle->m_typeface = std::move(tf);
+                it = m_pending.erase(it);
+                continue;
+            }
+            auto& entry = m_files[props.filename];
+            if (auto file = entry.lock(); file != nullptr)
+                preload.file = file;  // Mapped again meanwhile, keep one mapping per file
+            else
+                entry = preload.file;
+            handle->m_typeface = add_family(props.family)->add(props, std::move(preload));
+            adopted.push_back(handle->m_typeface);
+        } catch (std::exception const& e) {
+            handle->m_error = e.what();
+        }
+        it = m_pending.erase(it);
+    }
+    return adopted;
+}
+auto font_manager::add_family(std::string const& family_name) -> font_family_ref_t {
+    auto const it = m_families.find(family_name);
+    if (it != std::end(m_families)) return it->second;
+    auto family = make_ref<font_family>(family_name, shared_from_this());
+    m_families.insert({family_name, family});
+    return family;
+}
+auto font_manager::find_loaded(typeface_props const& props) const -> typeface_ref_t {
+    auto const family = m_families.find(props.family);
+    if (family == std::end(m_families)) return nullptr;
+    auto const& typefaces = family->second->typefaces();
+    auto const tf = typefaces.find(props.style);
+    return tf == std::end(typefaces) ? nullptr : tf->second;
+}
+auto font_manager::map_file(std::string const& filename) -> mapped_file_ref_t {
+    auto& entry = m_files[filename];
+    if (auto file = entry.lock(); file != nullptr) return file;
+    auto file = make_mapped_file(filename);
+    entry = file;
+    return file;
+}
+auto font_manager::acquire_face(std::string const& filename, std::int32_t index) -> font_face_ref_t {
+    auto& entry = m_faces[{filename, index}];
+    if (auto face = entry.lock(); face != nullptr) return face;
+    auto face = make_ref<font_face>(m_library, map_file(filename), index);
+    entry = face;
+    return face;
 }
 auto font_manager::family(std::string const& family_name) -> font_family_ref_t {
     // FIXME: Handle family name doesn't exist.
@@ -2,107 +2,300 @@
 #define TXT_FONTS_HPP
 #include <cstdint>
 #include <cstddef>
+#include <future>
+#include <map>
+#include <optional>
 #include <set>
+#include <vector>
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
 #include FT_LCD_FILTER_H
 #include FT_BITMAP_H
+#include FT_SIZES_H
 
 #include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
 
 #include "utility.hpp"
 #include "image.hpp"
+#include "coverage.hpp"
+#include "glyph_cache.hpp"
+#include "font_pack.hpp"
+#include "glyph_table.hpp"
+#include "msdf.hpp"
 
 namespace txt {
 enum class text_render_mode {
     normal,    // Gray scale anti-aliased
     sdf,       // (Signed Distance Field)
     subpixel,  // Using subpixel to anti-aliased
-    raster     // For rasterised font, scaled with nearest neighbor
+    raster,    // For rasterised font, scaled with nearest neighbor
+    msdf       // Multi-channel SDF generated from the outlines, keeps corners sharp at any scale
 };
 
 // Forward declaration
 struct glyph;
+class font_face;
 class typeface;
 class font_family;
 class font_manager;
+class font_handle;
 
 // Alias ref pointer
+using font_face_ref_t     = ref<font_face>;
 using typeface_ref_t      = ref<typeface>;
 using font_family_ref_t   = ref<font_family>;
 using font_manager_ref_t  = ref<font_manager>;
+using font_handle_ref_t   = ref<font_handle>;
 
+using typeface_weak_t     = weak<typeface>;
 using font_family_weak_t  = weak<font_family>;
 using font_manager_weak_t = weak<font_manager>;
 
 using character_range_t = std::array<std::uint32_t, 2>;
 
 constexpr character_range_t default_character_range{0, 128};
+// SDF glyphs are rasterized once at this size, or the typeface size when larger, and scaled when drawn.
+constexpr std::uint32_t sdf_pixel_size{48};
+// MSDF glyphs are always generated at this size, the median reconstructs the outline at any scale.
+constexpr std::uint32_t msdf_pixel_size{32};
+
+constexpr auto is_distance_field(text_render_mode mode) -> bool {
+    return mode == text_render_mode::sdf || mode == text_render_mode::msdf;
+}
 
 // I tried to follow the analogy from Google Fonts: Family, type family or font family.
 // https://fonts.google.com/knowledge/glossary/family_or_type_family_or_font_family
 
-// Contains the rendered bitmap, belongs to typeface
+// Metrics of a rendered glyph, belongs to typeface. The bitmap itself lives in the typeface's arena,
+// top-down rows of width * channels bytes starting at offset.
 struct glyph {
-    std::uint32_t  codepoint{0};
-    std::int32_t   bearing_left{0};
-    std::int32_t   bearing_top{0};
-    std::int64_t   advance_x{0};
-    std::int64_t   advance_y{0};
-    image_u8_ref_t bitmap{nullptr};
+    std::uint32_t codepoint{0};
+    std::int32_t  bearing_left{0};
+    std::int32_t  bearing_top{0};
+    std::int64_t  advance_x{0};
+    std::int64_t  advance_y{0};
+    std::uint32_t width{0};
+    std::uint32_t height{0};
+    std::size_t   offset{0};
+};
+
+// Layout data of every glyph as structure of arrays, indexed the same way as typeface::glyphs().
+// The per character loop only touches these and the atlas UVs, which are laid out the same way.
+struct glyph_metrics {
+    std::vector<std::int32_t> bearing_left{};
+    std::vector<std::int32_t> bearing_top{};
+    std::vector<std::int32_t> width{};
+    std::vector<std::int32_t> height{};
+    std::vector<std::int64_t> advance_x{};
+
+    auto size() const -> std::size_t { return advance_x.size(); }
+    auto push(glyph const& gh) -> void;
+    auto set(std::size_t index, glyph const& gh) -> void;
+    auto clear() -> void;
+};
+
+// Glyphs rendered away from the typeface, offsets point into the set's own arena.
+struct raster_set {
+    std::vector<glyph> glyphs{};
+    bitmap_arena       arena{};
+    bool               has_kerning{false};  // Of the face they came from, known without opening it again
 };
 
 struct typeface_props {
     std::string       filename;
+    std::int32_t      face_index{0};  // Face within a collection file (.ttc/.otc), 0 for single face files.
     std::uint32_t     size;
     std::string       family;
     std::string       style;
     text_render_mode  render_mode{text_render_mode::normal};
     character_range_t ranges{default_character_range};
     double            scale{1.0};
+    std::uint32_t     threads{1};  // Rasterization workers used when loading ranges, 0 uses all cores.
+    std::string       cache{};     // Glyph cache directory, empty disables the on-disk cache.
+    std::size_t       atlas_budget{0};  // Atlas bytes, cold glyphs are evicted to stay under it. 0 grows without bound.
+};
+
+// Work of a typeface load done away from the render thread: the mapped file, then either the opened
+// glyph cache or the rasterized ranges.
+struct typeface_preload {
+    mapped_file_ref_t file{nullptr};
+    glyph_cache_ref_t cache{nullptr};
+    raster_set        glyphs{};
+    font_pack_ref_t   pack{nullptr};  // Baked typeface, glyphs come from the cache and FreeType is never used
+};
+
+// FreeType face created from a memory-mapped font file, created by the font manager and shared by every
+// typeface using the same file and face index. Each typeface owns an FT_Size of it for its pixel size.
+class font_face {
+public:
+    font_face(FT_Library library, mapped_file_ref_t const& file, std::int32_t index);
+    ~font_face();
+    font_face(font_face const&) = delete;
+    auto operator=(font_face const&) -> font_face& = delete;
+
+    auto face() const -> FT_Face { return m_face; }
+    auto file() const -> mapped_file_ref_t const& { return m_file; }
+    auto index() const -> std::int32_t { return m_index; }
+    // Codepoints in the character map, built on first use.
+    auto coverage() -> coverage_set const&;
+    auto new_size() -> FT_Size;
+    auto done_size(FT_Size size) -> void;
+
+private:
+    friend font_manager;
+    auto detach() -> void { m_face = nullptr; }  // The library went first and released the face with it.
+
+private:
+    mapped_file_ref_t m_file;
+    std::int32_t      m_index;
+    FT_Face           m_face{nullptr};
+    coverage_set      m_coverage{};
+    bool              m_has_coverage{false};
 };
 
 // Contains the loaded font and rendered glyph, belongs to font family
 class typeface : public std::enable_shared_from_this<typeface> {
 public:
-    typeface(typeface_props const& props, font_family_weak_t const& font_family);
-    ~typeface() = default;
+    // A preload replaces loading the ranges, see font_manager::load_async.
+    typeface(typeface_props const& props, font_family_weak_t const& font_family, std::optional<typeface_preload> preload = std::nullopt);
+    ~typeface();
 
     auto filename() const -> std::string const& { return m_filename; }
+    auto face_index() const -> std::int32_t { return m_face_index; }
     auto size() const -> std::uint32_t { return m_size; }
     auto scale() const -> double { return m_scale; }
     auto mode() const -> text_render_mode { return m_mode; }
     auto glyph_size() const -> std::size_t { return m_max_glyph_size; }
-    auto glyphs() const -> std::unordered_map<std::uint32_t, glyph> const& { return m_glyphs; }
+    auto layout_scale() const -> float;  // Layout units per rasterized pixel, glyph metrics are drawn scaled by it
+    auto glyphs() const -> std::vector<glyph> const& { return m_glyphs; }
+    auto metrics() const -> glyph_metrics const& { return m_metrics; }
+    auto bitmaps() const -> bitmap_arena const& { return m_arena; }
+    auto bitmap(glyph const& gh) const -> std::uint8_t const* { return m_arena.data(gh.offset); }
     auto channels() const -> std::size_t { return m_channels; }
+    auto threads() const -> std::uint32_t { return m_threads; }
+    auto atlas_budget() const -> std::size_t { return m_atlas_budget; }
+    // Glyphs of the loaded ranges take the first indices and are never evicted.
+    auto pinned_glyphs() const -> std::size_t { return m_pinned; }
     auto family_name() const -> std::string const& { return m_family_name; }
+    // Whether kerning() can be anything but 0, opens the face unless the typeface is packed.
+    auto has_kerning() -> bool;
+    // Loaded from a font pack, glyphs outside it resolve to the fallbacks or space and reload is a no-op.
+    auto is_packed() const -> bool { return m_pack != nullptr; }
+    // Bumped whenever glyph indices or metrics may have changed, e.g. on reload.
+    auto generation() const -> std::uint64_t { return m_generation; }
+
+    // Glyph cache loaded on warm start, the atlas can be adopted as long as no glyph has been added since.
+    auto cache() const -> glyph_cache_ref_t const& { return m_cache; }
+    auto is_cache_stale() const -> bool { return m_cache_stale; }
+    // Atlas pages are stacked in one image, uvs hold the page in z.
+    auto store_cache(image_u8 const& atlas, std::size_t pages, std::vector<glm::vec3> const& uvs, std::size_t padding) -> void;
 
     auto set_size(std::uint32_t const& size) -> void;
     auto set_scale(double const& scale) -> void;
     auto set_mode(text_render_mode const& mode) -> void;
 
+    // Typefaces searched in order for codepoints this one doesn't cover. Their glyphs are rendered with
+    // this typeface's size and mode into its own glyphs and atlas, text mixing faces is still one draw.
+    // Fallbacks aren't kept alive, the chain keeps rendering from their font file after they're gone but
+    // fallbacks() only returns the live ones.
+    auto fallbacks() const -> std::vector<typeface_ref_t>;
+    auto add_fallback(typeface_ref_t const& other) -> void;
+
     auto reload() -> void;
+    // Render every loaded glyph again for a new content scale on worker threads. The current glyphs and
+    // scale stay in use until finish_rescale adopts the new ones, a newer scale supersedes a running one.
+    auto rescale(double const& scale) -> void;
+    auto is_rescaling() const -> bool { return m_rescale.valid(); }
+    // Call from the render thread between frames. Returns true when the new glyphs were adopted and the
+    // atlas has to be rebuilt.
+    auto finish_rescale() -> bool;
     auto query(std::uint32_t const& code) -> glyph const&;
+    // Drop a glyph loaded on demand, its index and bitmap are reused by the next glyph loaded. Bumps the
+    // generation, indices held elsewhere must be looked up again. Returns false for pinned glyphs.
+    auto evict(std::uint32_t const& index) -> bool;
+    // Pair kerning of the primary face in 26.6 pixels, 0 when either codepoint comes from a fallback.
+    auto kerning(std::uint32_t const& left, std::uint32_t const& right) -> std::int64_t;
+    // Dense index into glyphs() and metrics(), loads the glyph on a miss. Missing glyphs resolve to space.
+    auto index(std::uint32_t const& code) -> std::uint32_t {
+        auto const i = m_table.find(code);
+        return i != glyph_table::npos ? i : load_index(code);
+    }
 
 private:
     [[nodiscard]]auto retrieve_ft() -> std::pair<FT_Library, FT_Bitmap*>;
     auto init_rendering_mode(FT_Library library) -> void;
+    [[nodiscard]]auto retrieve_manager() -> font_manager_ref_t;
+    auto open_face() -> void;
+    auto activate_size() -> void;
+    auto settings() const -> typeface_props;
+    auto cache_path() const -> std::filesystem::path;
+    auto cache_key() const -> std::uint64_t;
+    auto load_cache() -> bool;
+    auto insert_cache() -> void;
     auto load(character_range_t const& range = default_character_range) -> void;
+    auto adopt(typeface_preload preload) -> void;
+    auto load_glyphs(std::vector<std::uint32_t> const& codes, FT_Library library, FT_Bitmap* bitmap) -> void;
     auto load_glyph(std::uint32_t const& code) -> void;
     auto load_glyph(std::uint32_t const& code, FT_Library library, FT_Bitmap* bitmap) -> void;
+    auto render_glyph(FT_Face face, std::uint32_t const& code, FT_Library library, FT_Bitmap* bitmap) -> std::optional<glyph>;
+    auto insert_glyph(glyph const& gh) -> void;  // Bitmap must already be in the arena
+    auto start_rescale(double const& scale) -> void;
+    auto load_index(std::uint32_t const& code) -> std::uint32_t;
+    auto kerning_of(std::uint32_t const& left, std::uint32_t const& right) -> std::int64_t;  // From the open face
+    auto compact_arena() -> void;
+    auto pixel_size() const -> std::uint32_t { return pixel_size(m_scale); }
+    auto pixel_size(double const& scale) const -> std::uint32_t;
+
+private:
+    // Weak, typefaces falling back to each other would keep one another alive. Only the file and face
+    // index are needed to render from it.
+    struct fallback {
+        typeface_weak_t typeface;
+        std::string     filename;
+        std::int32_t    face_index{0};
+        font_face_ref_t face{nullptr};  // Opened on the first codepoint the chain gets to
+        FT_Size         size{nullptr};
+    };
 
 private:
     std::string        m_filename;
+    std::int32_t       m_face_index;
     font_family_weak_t m_family;
     std::uint32_t      m_size;
     text_render_mode   m_mode;
     std::string        m_family_name;
     double             m_scale;
+    std::uint32_t      m_threads;
+    std::size_t        m_atlas_budget;
+    std::size_t        m_pinned{0};
     std::int32_t       m_flags{0x00};
     std::size_t        m_channels{0x00};
-    FT_Face            m_ft_face{nullptr};
-    std::unordered_map<std::uint32_t, glyph> m_glyphs{};
+    std::uint64_t      m_generation{0};
+    bool               m_has_kerning{false};
+    std::uint32_t      m_raster_size{0};  // Pixel size and mode the glyphs were rendered with
+    text_render_mode   m_raster_mode{text_render_mode::normal};
+    mapped_file_ref_t  m_file{nullptr};
+    font_face_ref_t    m_face{nullptr};
+    FT_Size            m_ft_size{nullptr};
+    character_range_t  m_ranges;
+    std::string        m_cache_dir;
+    glyph_cache_ref_t  m_cache{nullptr};
+    font_pack_ref_t    m_pack{nullptr};
+    bool               m_cache_stale{false};
+    glyph_table        m_table{};
+    std::vector<fallback>      m_fallbacks{};
+    std::vector<std::uint32_t> m_missing{};  // Codepoints aliased to space, looked up again when the chain changes
+    std::vector<glyph> m_glyphs{};
+    glyph_metrics      m_metrics{};
+    std::vector<std::uint32_t> m_free{};  // Evicted indices, filled before the glyphs grow
+    bitmap_arena       m_arena{};
+    std::size_t        m_arena_garbage{0};  // Bytes of evicted bitmaps still in the arena
+    std::future<raster_set> m_rescale{};
+    double             m_rescale_scale{1.0};  // Scale the running rescale renders at
+    double             m_rescale_to{1.0};     // Latest scale asked for
+    msdf_generator     m_msdf{};
     std::size_t m_max_glyph_size{0};
 };
 
@@ -114,7 +307,7 @@ public:
     auto name() const -> std::string const& { return m_name; }
     auto typefaces() const -> std::unordered_map<std::string, typeface_ref_t> const& { return m_typefaces; }
     auto reload() -> void;
-    auto add(typeface_props const& props) -> void;
+    auto add(typeface_props const& props, std::optional<typeface_preload> preload = std::nullopt) -> typeface_ref_t const&;
     auto typeface(std::string const& style) const -> typeface_ref_t const&;
 
 private:
@@ -127,6 +320,24 @@ private:
     std::unordered_map<std::string, typeface_ref_t> m_typefaces{};
 };
 
+// Typeface being loaded by font_manager::load_async. Resolved by font_manager::adopt_loaded, until then
+// typeface() is null and text drawn with it falls back to the default typeface.
+class font_handle {
+public:
+    auto props() const -> typeface_props const& { return m_props; }
+    auto is_ready() const -> bool { return m_typeface != nullptr; }
+    auto has_failed() const -> bool { return !m_error.empty(); }
+    auto error() const -> std::string const& { return m_error; }
+    auto typeface() const -> typeface_ref_t const& { return m_typeface; }
+
+private:
+    friend font_manager;
+    typeface_props                 m_props{};
+    std::future<typeface_preload>  m_job{};
+    typeface_ref_t                 m_typeface{nullptr};
+    std::string                    m_error{};
+};
+
 // Handle adding fonts and loading it. Do most of heavy lifting using freetype.
 class font_manager : public std::enable_shared_from_this<font_manager> {
 public:
@@ -136,17 +347,35 @@ public:
     auto families() const -> std::unordered_map<std::string, font_family_ref_t> const& { return m_families; }
     auto reload() -> void;
     auto load(typeface_props const& props) -> void;
+    // Typeface baked by txt-bake, its size, mode and scale come from the pack.
+    auto load_pack(std::string const& filename, std::string const& family, std::string const& style) -> void;
+    // Maps the file and rasterizes the ranges, or opens the glyph cache, on a worker and returns at once.
+    // A style that's already loaded resolves to its typeface right away, nothing is rendered again.
+    auto load_async(typeface_props const& props) -> font_handle_ref_t;
+    // Call from the render thread between frames. Creates the typefaces of finished loads, failed loads
+    // keep their error in the handle. A load whose style was added meanwhile resolves to that typeface.
+    auto adopt_loaded() -> std::vector<typeface_ref_t>;
     auto family(std::string const& family_name) -> font_family_ref_t;
 
 private:
     friend typeface;
     auto ft_library() -> FT_Library { return m_library; }
     auto ft_bitmap() -> FT_Bitmap* { return &m_bitmap; }
+    // Font files are mapped once and faces created once per file and face index, no matter how many
+    // sizes or styles use them. Both live as long as a typeface holds on to them.
+    auto map_file(std::string const& filename) -> mapped_file_ref_t;
+    auto acquire_face(std::string const& filename, std::int32_t index) -> font_face_ref_t;
+    auto add_family(std::string const& family_name) -> font_family_ref_t;
+    // Typeface of the props' family and style, null when it isn't loaded.
+    auto find_loaded(typeface_props const& props) const -> typeface_ref_t;
 
 private:
     FT_Library m_library{};
     FT_Bitmap  m_bitmap{};
     std::unordered_map<std::string, font_family_ref_t> m_families;
+    std::unordered_map<std::string, weak<mapped_file>> m_files{};
+    std::map<std::pair<std::string, std::int32_t>, weak<font_face>> m_faces{};
+    std::vector<font_handle_ref_t> m_pending{};
 };
 
 } // namespace txt
@@ -0,0 +1,124 @@
+#include "glyph_cache.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace txt {
+glyph_cache::glyph_cache(mapped_file_ref_t file, std::size_t offset) : m_file(file) {
+    auto const base = m_file->data() + offset;
+    m_header  = reinterpret_cast<glyph_cache_header const*>(base);
+    auto const records = reinterpret_cast<glyph_cache_record const*>(base + sizeof(glyph_cache_header));
+    m_records = {records, m_header->glyph_count};
+    auto const kerning = reinterpret_cast<glyph_cache_kerning const*>(records + m_header->glyph_count);
+    m_kerning = {kerning, m_header->kerning_count};
+    m_bitmaps = reinterpret_cast<std::uint8_t const*>(kerning + m_header->kerning_count);
+    m_atlas   = m_bitmaps + m_header->bitmap_bytes;
+}
+
+auto find_kerning(std::span<glyph_cache_kerning const> pairs, std::uint32_t const& left, std::uint32_t const& right) -> std::int64_t {
+    auto const it = std::lower_bound(std::begin(pairs), std::end(pairs), std::pair{left, right}, [](auto const& pair, auto const& key) {
+        return pair.left != key.first ? pair.left < key.first : pair.right < key.second;
+    });
+    if (it == std::end(pairs) || it->left != left || it->right != right) return 0;
+    return it->x;
+}
+
+auto glyph_cache_error(std::span<std::uint8_t const> bytes) -> char const* {
+    if (bytes.size() < sizeof(glyph_cache_header)) return "file is truncated";
+    auto const& header = *reinterpret_cast<glyph_cache_header const*>(bytes.data());
+    if (header.magic != glyph_cache_magic || header.version != glyph_cache_version) return "glyphs are not readable";
+    if (header.channels == 0 || header.channels > 4) return "channel count is invalid";
+    if (header.pages == 0 || header.atlas_height % header.pages != 0) return "atlas pages don't divide the atlas";
+    // Sizes are summed without overflowing, a huge count in a damaged header doesn't wrap around.
+    auto const tables = sizeof(glyph_cache_header)
+                      + std::size_t(header.glyph_count) * sizeof(glyph_cache_record)
+                      + std::size_t(header.kerning_count) * sizeof(glyph_cache_kerning);
+    auto const atlas = std::size_t(header.atlas_width) * header.atlas_height * header.channels;
+    if (tables > bytes.size() || atlas > bytes.size() - tables || header.bitmap_bytes != bytes.size() - tables - atlas)
+        return "size doesn't match its header";
+
+    // Records index the atlas pages and packers directly, their rectangle has to lie within a page.
+    auto const page_width  = double(header.atlas_width);
+    auto const page_height = double(header.atlas_height / header.pages);
+    auto const records = reinterpret_cast<glyph_cache_record const*>(bytes.data() + sizeof(glyph_cache_header));
+    for (auto const& record : std::span{records, header.glyph_count}) {
+        if (record.page >= header.pages) return "a glyph is on a page past the atlas";
+        auto const x = double(record.uv_x);
+        auto const y = double(record.uv_y);
+        if (!(x >= 0.0 && y >= 0.0 && x + record.width <= page_width && y + record.height <= page_height))
+            return "a glyph is outside its atlas page";
+        if (record.bitmap_offset > header.bitmap_bytes) return "a glyph bitmap is outside the file";
+        auto const available = header.bitmap_bytes - record.bitmap_offset;
+        if (record.width != 0 && std::uint64_t(record.height) * header.channels > available / record.width)
+            return "a glyph bitmap is outside the file";
+    }
+    return nullptr;
+}
+
+auto stamp_font_file(std::filesystem::path const& font) -> font_file_stamp {
+    std::error_code ec{};
+    auto const bytes = std::filesystem::file_size(font, ec);
+    if (ec) return {};
+    auto const time = std::filesystem::last_write_time(font, ec);
+    if (ec) return {};
+    return {std::uint64_t(bytes), std::int64_t(time.time_since_epoch().count())};
+}
+
+static auto matches_font(glyph_cache_header const& header, std::filesystem::path const& font) -> bool {
+    auto const stamp = stamp_font_file(font);
+    if (stamp.bytes == 0 || stamp.bytes != header.font_bytes) return false;
+    if (stamp.time == header.font_time) return true;
+    try {
+        auto const file = make_mapped_file(font);
+        return fnv1a(file->data(), file->size()) == header.font_hash;
+    } catch (std::exception const&) {
+        return false;
+    }
+}
+
+auto open_glyph_cache(std::filesystem::path const& filename, std::uint64_t key, std::filesystem::path const& font) -> glyph_cache_ref_t {
+    std::error_code ec{};
+    if (!std::filesystem::exists(filename, ec)) return nullptr;
+    mapped_file_ref_t file{nullptr};
+    try {
+        file = make_mapped_file(filename);
+    } catch (std::exception const&) {
+        return nullptr;
+    }
+    if (glyph_cache_error({file->data(), file->size()}) != nullptr) return nullptr;
+    auto const& header = *reinterpret_cast<glyph_cache_header const*>(file->data());
+    if (header.key != key || !matches_font(header, font)) return nullptr;
+    return make_ref<glyph_cache>(file);
+}
+
+auto write_glyph_cache(std::filesystem::path const& filename, glyph_cache_header const& header,
+                       std::vector<glyph_cache_record> const& records,
+                       std::vector<glyph_cache_kerning> const& kerning,
+                       std::vector<std::uint8_t> const& bitmaps,
+                       image_u8 const& atlas) -> bool {
+    std::error_code ec{};
+    if (filename.has_parent_path()) std::filesystem::create_directories(filename.parent_path(), ec);
+    if (ec) return false;
+
+    auto tmp = filename;
+    tmp += ".tmp";
+    {
+        std::ofstream output{tmp, std::ios::binary | std::ios::trunc};
+        if (!output.is_open()) return false;
+        if (!write_glyph_cache(output, header, records, kerning, bitmaps, atlas)) return false;
+    }
+    std::filesystem::rename(tmp, filename, ec);
+    return !ec;
+}
+auto write_glyph_cache(std::ostream& output, glyph_cache_header const& header,
+                       std::vector<glyph_cache_record> const& records,
+                       std::vector<glyph_cache_kerning> const& kerning,
+                       std::vector<std::uint8_t> const& bitmaps,
+                       image_u8 const& atlas) -> bool {
+    output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    output.write(reinterpret_cast<char const*>(records.data()), std::streamsize(records.size() * sizeof(glyph_cache_record)));
+    output.write(reinterpret_cast<char const*>(kerning.data()), std::streamsize(kerning.size() * sizeof(glyph_cache_kerning)));
+    output.write(reinterpret_cast<char const*>(bitmaps.data()), std::streamsize(bitmaps.size()));
+    output.write(reinterpret_cast<char const*>(atlas.data()), std::streamsize(atlas.bytes()));
+    return output.good();
+}
+} // namespace txt
@@ -0,0 +1,127 @@
+#ifndef TXT_GLYPH_CACHE_HPP
+#define TXT_GLYPH_CACHE_HPP
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <vector>
+#include <filesystem>
+
+#include "utility.hpp"
+#include "image.hpp"
+#include "mapped_file.hpp"
+
+namespace txt {
+// On-disk layout, the file is memory mapped and read in place:
+//   glyph_cache_header
+//   glyph_cache_record[glyph_count]
+//   glyph_cache_kerning[kerning_count], sorted by left then right codepoint
+//   std::uint8_t bitmaps[bitmap_bytes]
+//   std::uint8_t atlas[atlas_width * atlas_height * channels], pages stacked bottom to top
+inline constexpr std::uint32_t glyph_cache_magic   = 0x43475854;  // "TXGC"
+inline constexpr std::uint32_t glyph_cache_version = 5;
+
+struct glyph_cache_header {
+    std::uint32_t magic{glyph_cache_magic};
+    std::uint32_t version{glyph_cache_version};
+    std::uint64_t key{0};
+    std::uint32_t channels{0};
+    std::uint32_t glyph_count{0};
+    std::uint32_t atlas_width{0};
+    std::uint32_t atlas_height{0};
+    std::uint32_t padding{0};  // Atlas padding between glyphs
+    std::uint32_t pages{1};    // Atlas pages of atlas_height / pages rows each
+    std::uint64_t bitmap_bytes{0};
+    std::uint32_t kerning_count{0};
+    std::uint32_t flags{0};
+    std::uint64_t font_bytes{0};  // Font file the glyphs were rendered from, see open_glyph_cache
+    std::int64_t  font_time{0};
+    std::uint64_t font_hash{0};
+};
+static_assert(sizeof(glyph_cache_header) == 80);
+
+// Header flags for the kerning of the primary face, answered from the cache until the face has to be
+// opened for a glyph.
+inline constexpr std::uint32_t glyph_cache_has_kerning = 1 << 0;  // The face has pair kerning
+inline constexpr std::uint32_t glyph_cache_all_kerning = 1 << 1;  // Every non-zero pair of the records is stored
+
+struct glyph_cache_record {
+    std::uint32_t codepoint{0};
+    std::int32_t  bearing_left{0};
+    std::int32_t  bearing_top{0};
+    std::uint32_t width{0};
+    std::uint32_t height{0};
+    float         uv_x{0.0f};
+    float         uv_y{0.0f};
+    std::uint32_t page{0};
+    std::int64_t  advance_x{0};
+    std::int64_t  advance_y{0};
+    std::uint64_t bitmap_offset{0};
+};
+static_assert(sizeof(glyph_cache_record) == 56);
+
+struct glyph_cache_kerning {
+    std::uint32_t left{0};
+    std::uint32_t right{0};
+    std::int64_t  x{0};  // 26.6 pixels
+};
+static_assert(sizeof(glyph_cache_kerning) == 16);
+
+// Binary search of sorted pairs, 0 when the pair isn't there.
+auto find_kerning(std::span<glyph_cache_kerning const> pairs, std::uint32_t const& left, std::uint32_t const& right) -> std::int64_t;
+
+class glyph_cache {
+public:
+    // The cache starts at offset, e.g. embedded in a font pack.
+    glyph_cache(mapped_file_ref_t file, std::size_t offset = 0);
+    ~glyph_cache() = default;
+
+    auto header() const -> glyph_cache_header const& { return *m_header; }
+    auto records() const -> std::span<glyph_cache_record const> { return m_records; }
+    auto kerning() const -> std::span<glyph_cache_kerning const> { return m_kerning; }
+    // Pair kerning in 26.6 pixels, 0 for pairs that weren't stored.
+    auto kerning(std::uint32_t const& left, std::uint32_t const& right) const -> std::int64_t { return find_kerning(m_kerning, left, right); }
+    auto bitmap(glyph_cache_record const& record) const -> std::uint8_t const* { return m_bitmaps + record.bitmap_offset; }
+    auto bitmaps() const -> std::uint8_t const* { return m_bitmaps; }
+    auto atlas() const -> std::uint8_t const* { return m_atlas; }
+
+private:
+    mapped_file_ref_t                   m_file;
+    glyph_cache_header const*           m_header{nullptr};
+    std::span<glyph_cache_record const> m_records{};
+    std::span<glyph_cache_kerning const> m_kerning{};
+    std::uint8_t const*                 m_bitmaps{nullptr};
+    std::uint8_t const*                 m_atlas{nullptr};
+};
+
+using glyph_cache_ref_t = ref<glyph_cache>;
+
+// Why the cache in bytes can't be read in place, nullptr when it can. Every record's bitmap must lie
+// within the bitmaps and its atlas rectangle within its page, nothing is read or written out of bounds
+// for a damaged file.
+auto glyph_cache_error(std::span<std::uint8_t const> bytes) -> char const*;
+// Size and last write time of a font file, what a cache is matched against on every start.
+struct font_file_stamp {
+    std::uint64_t bytes{0};
+    std::int64_t  time{0};
+};
+auto stamp_font_file(std::filesystem::path const& font) -> font_file_stamp;
+
+// Returns nullptr when the file is missing, malformed or was written for another key or font file. The
+// font file is matched by its stamp, its content is only hashed when the stamp differs but the size
+// doesn't, e.g. after a copy.
+auto open_glyph_cache(std::filesystem::path const& filename, std::uint64_t key, std::filesystem::path const& font) -> glyph_cache_ref_t;
+// Write is done to a temporary file and renamed, so readers never see a partial cache.
+auto write_glyph_cache(std::filesystem::path const& filename, glyph_cache_header const& header,
+                       std::vector<glyph_cache_record> const& records,
+                       std::vector<glyph_cache_kerning> const& kerning,
+                       std::vector<std::uint8_t> const& bitmaps,
+                       image_u8 const& atlas) -> bool;
+auto write_glyph_cache(std::ostream& output, glyph_cache_header const& header,
+                       std::vector<glyph_cache_record> const& records,
+                       std::vector<glyph_cache_kerning> const& kerning,
+                       std::vector<std::uint8_t> const& bitmaps,
+                       image_u8 const& atlas) -> bool;
+} // namespace txt
+
+#endif  // TXT_GLYPH_CACHE_HPP
@@ -0,0 +1,104 @@
+#include "glyph_table.hpp"
+#include <algorithm>
+
+namespace txt {
+glyph_table::glyph_table() {
+    clear();
+}
+
+auto glyph_table::insert(std::uint32_t const& code, std::uint32_t const& index) -> void {
+    if (code >= bmp_end) {
+        insert_sparse(code, index);
+        return;
+    }
+    auto& page = m_directory[code >> page_bits];
+    if (page == npos) {
+        page = std::uint32_t(m_pages.size());
+        m_pages.emplace_back();
+        m_pages.back().fill(npos);
+    }
+    auto& value = m_pages[page][code & page_mask];
+    if (value == npos) ++m_size;
+    value = index;
+}
+
+auto glyph_table::erase(std::uint32_t const& code) -> void {
+    if (code < bmp_end) {
+        auto const page = m_directory[code >> page_bits];
+        if (page == npos || m_pages[page][code & page_mask] == npos) return;
+        m_pages[page][code & page_mask] = npos;
+        --m_size;
+        return;
+    }
+    if (m_keys.empty()) return;
+    for (auto i = slot(code); m_keys[i] != empty; i = (i + 1) & (m_keys.size() - 1)) {
+        if (m_keys[i] != code) continue;
+        m_keys[i]   = tombstone;
+        m_values[i] = npos;
+        --m_size;
+        return;
+    }
+}
+
+auto glyph_table::clear() -> void {
+    m_size = 0;
+    m_directory.fill(npos);
+    m_pages.clear();
+    m_keys.clear();
+    m_values.clear();
+    m_sparse_used = 0;
+    // ASCII and Latin-1 are always needed, keep their page at the front.
+    m_directory[0] = 0;
+    m_pages.emplace_back();
+    m_pages.back().fill(npos);
+}
+
+auto glyph_table::find_sparse(std::uint32_t const& code) const -> std::uint32_t {
+    if (m_keys.empty()) return npos;
+    for (auto i = slot(code); m_keys[i] != empty; i = (i + 1) & (m_keys.size() - 1)) {
+        if (m_keys[i] == code) return m_values[i];
+    }
+    return npos;
+}
+
+auto glyph_table::insert_sparse(std::uint32_t const& code, std::uint32_t const& index) -> void {
+    // Keep the load factor below one half, probes stay short.
+    if ((m_sparse_used + 1) * 2 > m_keys.size())
+        rehash(std::max<std::size_t>(16, m_keys.size() * 2));
+
+    auto target = m_keys.size();
+    auto i = slot(code);
+    for (; m_keys[i] != empty; i = (i + 1) & (m_keys.size() - 1)) {
+        if (m_keys[i] == code) {
+            m_values[i] = index;
+            return;
+        }
+        if (m_keys[i] == tombstone && target == m_keys.size()) target = i;
+    }
+    if (target == m_keys.size()) {
+        target = i;
+        ++m_sparse_used;
+    }
+    m_keys[target]   = code;
+    m_values[target] = index;
+    ++m_size;
+}
+
+auto glyph_table::rehash(std::size_t capacity) -> void {
+    auto const keys   = std::move(m_keys);
+    auto const values = std::move(m_values);
+    // Tombstones are dropped while reinserting.
+    while (capacity < (m_sparse_used + 1) * 2) capacity *= 2;
+    m_keys.assign(capacity, empty);
+    m_values.assign(capacity, npos);
+    m_sparse_used = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == empty || keys[i] == tombstone) continue;
+        auto j = slot(keys[i]);
+        while (m_keys[j] != empty) j = (j + 1) & (m_keys.size() - 1);
+        m_keys[j]   = keys[i];
+        m_values[j] = values[i];
+        ++m_sparse_used;
+    }
+}
+} // namespace txt
@@ -0,0 +1,62 @@
+#ifndef TXT_GLYPH_TABLE_HPP
+#define TXT_GLYPH_TABLE_HPP
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+
+#include "utility.hpp"
+
+namespace txt {
+// Maps codepoints to dense glyph indices. The Basic Multilingual Plane is looked up through directly
+// indexed pages of 256 codepoints, pages are only allocated for blocks that are in use. Codepoints
+// above the BMP are rare and live in a small open-addressing table with linear probing.
+class glyph_table {
+public:
+    static constexpr std::uint32_t npos = limits<std::uint32_t>::max();
+
+public:
+    glyph_table();
+    ~glyph_table() = default;
+
+    auto size() const -> std::size_t { return m_size; }
+    auto find(std::uint32_t const& code) const -> std::uint32_t {
+        if (code < bmp_end) {
+            auto const page = m_directory[code >> page_bits];
+            if (page == npos) return npos;
+            return m_pages[page][code & page_mask];
+        }
+        return find_sparse(code);
+    }
+    auto insert(std::uint32_t const& code, std::uint32_t const& index) -> void;
+    auto erase(std::uint32_t const& code) -> void;
+    auto clear() -> void;
+
+private:
+    static constexpr std::uint32_t bmp_end   = 0x10000;
+    static constexpr std::uint32_t page_bits = 8;
+    static constexpr std::uint32_t page_size = 1 << page_bits;
+    static constexpr std::uint32_t page_mask = page_size - 1;
+    static constexpr std::uint32_t empty     = npos;      // Sparse slot never used
+    static constexpr std::uint32_t tombstone = npos - 1;  // Sparse slot erased, probing continues past it
+
+    using page_t = std::array<std::uint32_t, page_size>;
+
+    auto find_sparse(std::uint32_t const& code) const -> std::uint32_t;
+    auto insert_sparse(std::uint32_t const& code, std::uint32_t const& index) -> void;
+    auto rehash(std::size_t capacity) -> void;
+    auto slot(std::uint32_t const& code) const -> std::size_t {
+        return std::size_t((code * 0x9E3779B1u) >> 7) & (m_keys.size() - 1);
+    }
+
+private:
+    std::size_t m_size{0};
+    std::array<std::uint32_t, bmp_end / page_size> m_directory{};
+    std::vector<page_t>        m_pages{};
+    std::vector<std::uint32_t> m_keys{};
+    std::vector<std::uint32_t> m_values{};
+    std::size_t                m_sparse_used{0};  // Live entries and tombstones
+};
+} // namespace txt
+
+#endif  // TXT_GLYPH_TABLE_HPP
@@ -2,9 +2,11 @@
 #define TXT_IMAGE_HPP
 #include <cstdint>
 #include <cstddef>
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <string_view>
+#include <vector>
 
 #include "fmt/format.h"
 #include "utility.hpp"
@@ -65,6 +67,18 @@ public:
         m_buffer = new T[m_size];
         std::memset(m_buffer, 0x00, m_size * sizeof(T));
     }
+    // Add zeroed rows at the end, the existing pixels are kept.
+    auto grow(std::size_t height) -> void {
+        if (height <= m_height) return;
+        auto const size = m_width * height * m_channels;
+        auto buffer = new T[size];
+        std::memcpy(buffer, m_buffer, m_size * sizeof(T));
+        std::memset(buffer + m_size, 0x00, (size - m_size) * sizeof(T));
+        delete[] m_buffer;
+        m_buffer = buffer;
+        m_height = height;
+        m_size   = size;
+    }
     auto width() const noexcept -> std::size_t { return m_width; }
     auto height() const noexcept -> std::size_t { return m_height; }
     auto channels() const noexcept -> std::size_t { return m_channels; }
@@ -88,6 +102,21 @@ public:
         for (std::size_t i = 0; i < m_channels && i < Channels; ++i)
             m_buffer[index + i] = color[i];
     }
+    // Copy count pixels of tightly packed data into row y starting at column x, clipped to the image.
+    auto set_row(std::size_t x, std::size_t y, T const* data, std::size_t count) noexcept -> void {
+        if (!is_valid_range(x, y)) return;
+        count = std::min(count, m_width - x);
+        std::memcpy(m_buffer + pixel_index(x, y), data, count * m_channels * sizeof(T));
+    }
+
+    // Zero a rectangle of pixels, clipped to the image.
+    auto clear(std::size_t x, std::size_t y, std::size_t width, std::size_t height) noexcept -> void {
+        if (!is_valid_range(x, y)) return;
+        width  = std::min(width, m_width - x);
+        height = std::min(height, m_height - y);
+        for (std::size_t i = 0; i < height; ++i)
+            std::memset(m_buffer + pixel_index(x, y + i), 0x00, width * m_channels * sizeof(T));
+    }
 
     auto fliph() noexcept -> void {
         for (std::size_t i = 0; i < m_height / 2; i++) {
@@ -126,6 +155,30 @@ private:
     std::size_t  m_size;
 };
 
+// Many small bitmaps stored back to back in one growable buffer, referenced by byte offset.
+// Offsets stay valid when the buffer grows, pointers returned by data() do not.
+class bitmap_arena {
+public:
+    auto bytes() const noexcept -> std::size_t { return m_buffer.size(); }
+    auto buffer() const noexcept -> std::vector<std::uint8_t> const& { return m_buffer; }
+    auto data(std::size_t offset) const noexcept -> std::uint8_t const* { return m_buffer.data() + offset; }
+
+    auto allocate(std::uint8_t const* data, std::size_t bytes) -> std::size_t {
+        auto const offset = m_buffer.size();
+        m_buffer.insert(std::end(m_buffer), data, data + bytes);
+        return offset;
+    }
+    // Append another arena and return the offset its contents start at.
+    auto append(bitmap_arena const& other) -> std::size_t {
+        return allocate(other.m_buffer.data(), other.m_buffer.size());
+    }
+    auto reserve(std::size_t bytes) -> void { m_buffer.reserve(bytes); }
+    auto clear() -> void { m_buffer.clear(); }
+
+private:
+    std::vector<std::uint8_t> m_buffer{};
+};
+
 using image_u8 = image<std::uint8_t>;
 using image_u8_ref_t = ref<image_u8>;
 
@@ -0,0 +1,155 @@
+#include "line_break.hpp"
+#include <algorithm>
+#include <array>
+
+namespace txt {
+namespace {
+using enum line_break_class;
+
+struct class_range {
+    std::uint32_t    first;
+    std::uint32_t    last;  // Inclusive
+    line_break_class cls;
+};
+
+// Sorted and non-overlapping. Latin, general punctuation, combining marks and the common CJK blocks.
+constexpr class_range class_ranges[]{
+    {0x0009, 0x0009, BA}, {0x000A, 0x000A, LF}, {0x000B, 0x000C, BK}, {0x000D, 0x000D, CR},
+    {0x0020, 0x0020, SP}, {0x0021, 0x0021, EX}, {0x0022, 0x0022, QU}, {0x0024, 0x0024, PR},
+    {0x0025, 0x0025, PO}, {0x0027, 0x0027, QU}, {0x0028, 0x0028, OP}, {0x0029, 0x0029, CP},
+    {0x002B, 0x002B, PR}, {0x002C, 0x002C, IS}, {0x002D, 0x002D, HY}, {0x002E, 0x002E, IS},
+    {0x002F, 0x002F, SY}, {0x0030, 0x0039, NU}, {0x003A, 0x003B, IS}, {0x003F, 0x003F, EX},
+    {0x005B, 0x005B, OP}, {0x005C, 0x005C, PR}, {0x005D, 0x005D, CP}, {0x007B, 0x007B, OP},
+    {0x007C, 0x007C, BA}, {0x007D, 0x007D, CL}, {0x0085, 0x0085, NL}, {0x00A0, 0x00A0, GL},
+    {0x00A1, 0x00A1, OP}, {0x00A2, 0x00A2, PO}, {0x00A3, 0x00A5, PR}, {0x00AB, 0x00AB, QU},
+    {0x00AD, 0x00AD, BA}, {0x00B0, 0x00B0, PO}, {0x00B1, 0x00B1, PR}, {0x00BB, 0x00BB, QU},
+    {0x00BF, 0x00BF, OP}, {0x0300, 0x036F, CM}, {0x0483, 0x0489, CM}, {0x0591, 0x05BD, CM},
+    {0x0610, 0x061A, CM}, {0x064B, 0x065F, CM}, {0x1AB0, 0x1AFF, CM}, {0x1DC0, 0x1DFF, CM},
+    {0x200B, 0x200B, ZW}, {0x200C, 0x200D, CM}, {0x2010, 0x2010, BA}, {0x2011, 0x2011, GL},
+    {0x2012, 0x2013, BA}, {0x2014, 0x2014, B2}, {0x2018, 0x2019, QU}, {0x201C, 0x201D, QU},
+    {0x2024, 0x2026, IN}, {0x2028, 0x2029, BK}, {0x202F, 0x202F, GL}, {0x2030, 0x2037, PO},
+    {0x2039, 0x203A, QU}, {0x2044, 0x2044, IS}, {0x2060, 0x2060, WJ}, {0x20A0, 0x20CF, PR},
+    {0x20D0, 0x20FF, CM}, {0x2E80, 0x2FFF, ID}, {0x3000, 0x3000, BA}, {0x3001, 0x3002, CL},
+    {0x3005, 0x3005, NS}, {0x3008, 0x3008, OP}, {0x3009, 0x3009, CL}, {0x300A, 0x300A, OP},
+    {0x300B, 0x300B, CL}, {0x300C, 0x300C, OP}, {0x300D, 0x300D, CL}, {0x300E, 0x300E, OP},
+    {0x300F, 0x300F, CL}, {0x3010, 0x3010, OP}, {0x3011, 0x3011, CL}, {0x3041, 0x3096, ID},
+    {0x309D, 0x309E, NS}, {0x30A1, 0x30FA, ID}, {0x30FB, 0x30FB, NS}, {0x30FC, 0x30FE, NS},
+    {0x3400, 0x4DBF, ID}, {0x4E00, 0x9FFF, ID}, {0xAC00, 0xD7A3, ID}, {0xF900, 0xFAFF, ID},
+    {0xFE20, 0xFE2F, CM}, {0xFEFF, 0xFEFF, WJ}, {0xFF01, 0xFF01, EX}, {0xFF08, 0xFF08, OP},
+    {0xFF09, 0xFF09, CL}, {0xFF0C, 0xFF0C, CL}, {0xFF0E, 0xFF0E, CL}, {0xFF1A, 0xFF1B, NS},
+    {0xFF1F, 0xFF1F, EX}, {0x1F000, 0x1FAFF, ID}, {0x20000, 0x3FFFD, ID},
+};
+static_assert([] {
+    for (std::size_t i = 0; i < std::size(class_ranges); ++i) {
+        if (class_ranges[i].first > class_ranges[i].last) return false;
+        if (i > 0 && class_ranges[i - 1].last >= class_ranges[i].first) return false;
+    }
+    return true;
+}(), "Line break class ranges must be sorted and must not overlap");
+
+constexpr auto ascii_classes = [] {
+    std::array<line_break_class, 128> classes{};
+    classes.fill(AL);
+    for (auto const& range : class_ranges) {
+        for (auto code = range.first; code <= range.last && code < classes.size(); ++code)
+            classes[code] = range.cls;
+    }
+    return classes;
+}();
+
+// Pair table of UAX #14 for the classes up to WJ, row is the class before the opportunity and column
+// the class after it. '_' direct break, '%' only with spaces in between, '^' never, '#' and '@' the same
+// for a combining mark after the class.
+constexpr std::size_t pair_classes = std::size_t(WJ) + 1;
+constexpr char pair_table[pair_classes][pair_classes + 1]{
+//   OP CL CP QU GL NS EX SY IS PR PO NU AL ID IN HY BA BB B2 ZW CM WJ
+    "^^^^^^^^^^^^^^^^^^^^@^",  // OP
+    "_^^%%^^^^%%____%%__^#^",  // CL
+    "_^^%%^^^^%%%%__%%__^#^",  // CP
+    "^^^%%%^^^%%%%%%%%%%^#^",  // QU
+    "%^^%%%^^^%%%%%%%%%%^#^",  // GL
+    "_^^%%%^^^______%%__^#^",  // NS
+    "_^^%%%^^^_____%%%__^#^",  // EX
+    "_^^%%%^^^__%___%%__^#^",  // SY
+    "_^^%%%^^^__%%__%%__^#^",  // IS
+    "%^^%%%^^^__%%%_%%__^#^",  // PR
+    "%^^%%%^^^__%%__%%__^#^",  // PO
+    "%^^%%%^^^%%%%_%%%__^#^",  // NU
+    "%^^%%%^^^%%%%_%%%__^#^",  // AL
+    "_^^%%%^^^_%___%%%__^#^",  // ID
+    "_^^%%%^^^_____%%%__^#^",  // IN
+    "_^^%_%^^^__%___%%__^#^",  // HY
+    "_^^%_%^^^______%%__^#^",  // BA
+    "%^^%%%^^^%%%%%%%%%%^#^",  // BB
+    "_^^%%%^^^______%%_^^#^",  // B2
+    "___________________^__",  // ZW
+    "%^^%%%^^^%%%%_%%%__^#^",  // CM
+    "%^^%%%^^^%%%%%%%%%%^#^",  // WJ
+};
+static_assert([] {
+    for (auto const& row : pair_table) {
+        for (std::size_t i = 0; i < pair_classes; ++i) {
+            if (row[i] != '_' && row[i] != '%' && row[i] != '^' && row[i] != '#' && row[i] != '@') return false;
+        }
+    }
+    return true;
+}(), "Every pair of classes needs an action");
+} // namespace
+
+auto line_break_class_of(std::uint32_t code) -> line_break_class {
+    if (code < ascii_classes.size()) return ascii_classes[code];
+    auto const it = std::upper_bound(std::begin(class_ranges), std::end(class_ranges), code, [](std::uint32_t value, class_range const& range) {
+        return value < range.first;
+    });
+    if (it == std::begin(class_ranges)) return AL;
+    auto const& range = *std::prev(it);
+    return code <= range.last ? range.cls : AL;
+}
+
+auto line_breaks(std::span<std::uint32_t const> codes, std::vector<break_action>& breaks) -> void {
+    breaks.assign(codes.size(), break_action::none);
+    if (codes.empty()) return;
+
+    // A line never starts with a break, leading spaces and marks behave like WJ and AL (LB10).
+    auto const start_class = [](line_break_class cls) {
+        if (cls == SP) return WJ;
+        if (cls == CM) return AL;
+        return cls;
+    };
+    auto cls = start_class(line_break_class_of(codes[0]));
+    auto after_space = false;
+    for (std::size_t i = 1; i < codes.size(); ++i) {
+        auto const next = line_break_class_of(codes[i]);
+        // Hard line ends, CR LF is a single one (LB4, LB5).
+        if (cls == BK || cls == LF || cls == NL || (cls == CR && next != LF)) {
+            breaks[i]   = break_action::mandatory;
+            cls         = start_class(next);
+            after_space = false;
+            continue;
+        }
+        // Spaces never start a break and don't change the class before them (LB6, LB7).
+        if (next == SP) {
+            after_space = true;
+            continue;
+        }
+        if (is_line_end(next)) {
+            cls         = next;
+            after_space = false;
+            continue;
+        }
+
+        auto const action = pair_table[std::size_t(cls)][std::size_t(next)];
+        if (action == '_') {
+            breaks[i] = break_action::allowed;
+        } else if (action == '%') {
+            if (after_space) breaks[i] = break_action::allowed;
+        } else if (action == '#' || action == '@') {
+            // A mark joins the class before it (LB9), after a space it stands alone as AL (LB10).
+            if (!after_space) continue;
+            if (action == '#') breaks[i] = break_action::allowed;
+        }
+        cls         = next;
+        after_space = false;
+    }
+}
+} // namespace txt
@@ -0,0 +1,33 @@
+#ifndef TXT_LINE_BREAK_HPP
+#define TXT_LINE_BREAK_HPP
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace txt {
+// Line breaking classes of UAX #14, https://www.unicode.org/reports/tr14/. A subset: HL, SA, AI and
+// the like resolve to AL, Hangul syllables and emoji to ID, ZWJ to CM.
+enum class line_break_class : std::uint8_t {
+    OP, CL, CP, QU, GL, NS, EX, SY, IS, PR, PO, NU, AL, ID, IN, HY, BA, BB, B2, ZW, CM, WJ,  // Pair table order
+    SP, BK, CR, LF, NL,
+};
+
+enum class break_action : std::uint8_t {
+    none,       // Not allowed before this codepoint
+    allowed,    // Line may wrap before this codepoint
+    mandatory,  // Previous codepoint ends the line, e.g. after '\n'
+};
+
+// Class from a compile-time table of codepoint ranges, unlisted codepoints are AL.
+auto line_break_class_of(std::uint32_t code) -> line_break_class;
+constexpr auto is_line_end(line_break_class cls) -> bool {
+    return cls == line_break_class::BK || cls == line_break_class::CR || cls == line_break_class::LF || cls == line_break_class::NL;
+}
+
+// Break opportunities with the pair table algorithm of UAX #14. breaks[i] is the action before codes[i],
+// the first is always none. The end of the text is not included.
+auto line_breaks(std::span<std::uint32_t const> codes, std::vector<break_action>& breaks) -> void;
+} // namespace txt
+
+#endif  // TXT_LINE_BREAK_HPP
@@ -0,0 +1,72 @@
+#include "mapped_file.hpp"
+#include <stdexcept>
+#include "fmt/format.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace txt {
+auto make_mapped_file(std::filesystem::path const& filename) -> mapped_file_ref_t {
+    return make_ref<mapped_file>(filename);
+}
+
+#ifdef _WIN32
+mapped_file::mapped_file(std::filesystem::path const& filename) : m_filename(filename) {
+    auto file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(fmt::format("Failed to open '{}' for mapping!", filename.string()));
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    m_size = std::size_t(size.QuadPart);
+    if (m_size == 0) {
+        CloseHandle(file);
+        return;
+    }
+    m_native = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (m_native == nullptr)
+        throw std::runtime_error(fmt::format("Failed to create file mapping for '{}'!", filename.string()));
+    m_data = static_cast<std::uint8_t const*>(MapViewOfFile(m_native, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        CloseHandle(m_native);
+        throw std::runtime_error(fmt::format("Failed to map view of '{}'!", filename.string()));
+    }
+}
+mapped_file::~mapped_file() {
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_native != nullptr) CloseHandle(m_native);
+}
+#else
+mapped_file::mapped_file(std::filesystem::path const& filename) : m_filename(filename) {
+    auto const fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error(fmt::format("Failed to open '{}' for mapping!", filename.string()));
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error(fmt::format("Failed to stat '{}'!", filename.string()));
+    }
+    m_size = std::size_t(info.st_size);
+    if (m_size == 0) {
+        close(fd);
+        return;
+    }
+    auto const ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps its own reference to the file
+    if (ptr == MAP_FAILED)
+        throw std::runtime_error(fmt::format("Failed to map '{}'!", filename.string()));
+    m_data = static_cast<std::uint8_t const*>(ptr);
+}
+mapped_file::~mapped_file() {
+    if (m_data != nullptr) munmap(const_cast<std::uint8_t*>(m_data), m_size);
+}
+#endif
+} // namespace txt
@@ -0,0 +1,33 @@
+#ifndef TXT_MAPPED_FILE_HPP
+#define TXT_MAPPED_FILE_HPP
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+#include "utility.hpp"
+
+namespace txt {
+// Read-only memory mapping of a whole file.
+class mapped_file {
+public:
+    mapped_file(std::filesystem::path const& filename);
+    ~mapped_file();
+    mapped_file(mapped_file const&) = delete;
+    auto operator=(mapped_file const&) -> mapped_file& = delete;
+
+    auto filename() const -> std::filesystem::path const& { return m_filename; }
+    auto data() const noexcept -> std::uint8_t const* { return m_data; }
+    auto size() const noexcept -> std::size_t { return m_size; }
+
+private:
+    std::filesystem::path m_filename;
+    std::uint8_t const*   m_data{nullptr};
+    std::size_t           m_size{0};
+    void*                 m_native{nullptr};  // File mapping handle on Windows
+};
+
+using mapped_file_ref_t = ref<mapped_file>;
+auto make_mapped_file(std::filesystem::path const& filename) -> mapped_file_ref_t;
+} // namespace txt
+
+#endif  // TXT_MAPPED_FILE_HPP
@@ -0,0 +1,428 @@
+#include "msdf.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace txt {
+namespace {
+// Channel masks, an edge contributes to every channel of its color.
+constexpr std::uint8_t black   = 0;
+constexpr std::uint8_t red     = 1;
+constexpr std::uint8_t green   = 2;
+constexpr std::uint8_t yellow  = 3;
+constexpr std::uint8_t blue    = 4;
+constexpr std::uint8_t magenta = 5;
+constexpr std::uint8_t cyan    = 6;
+constexpr std::uint8_t white   = 7;
+
+constexpr std::uint8_t extend_start = 1;
+constexpr std::uint8_t extend_end   = 2;
+
+constexpr float corner_threshold = 0.14112f;  // sin(3.0), edges meeting at a sharper angle form a corner
+constexpr float flatness         = 1.0f;      // Target segment length in pixels when flattening curves
+constexpr std::size_t max_curve_segments = 16;
+constexpr float tie_epsilon      = 1e-5f;     // Relative, segments sharing an end point are equally close
+constexpr std::int32_t padding   = std::int32_t(msdf_range / 2.0f) + 1;
+
+auto cross(glm::vec2 const& a, glm::vec2 const& b) -> float { return a.x * b.y - a.y * b.x; }
+auto dot(glm::vec2 const& a, glm::vec2 const& b) -> float { return a.x * b.x + a.y * b.y; }
+auto length(glm::vec2 const& a) -> float { return std::sqrt(dot(a, a)); }
+auto normalize(glm::vec2 const& a) -> glm::vec2 {
+    auto const l = length(a);
+    return l > 0.0f ? a / l : glm::vec2{0.0f};
+}
+auto median(float a, float b, float c) -> float {
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+auto is_corner(glm::vec2 const& a, glm::vec2 const& b) -> bool {
+    return dot(a, b) <= 0.0f || std::abs(cross(a, b)) > corner_threshold;
+}
+// Cycle through cyan, magenta and yellow, never reusing a channel of banned on its own.
+auto switch_color(std::uint8_t& color, std::uint64_t& seed, std::uint8_t banned = black) -> void {
+    auto const combined = std::uint8_t(color & banned);
+    if (combined == red || combined == green || combined == blue) {
+        color = std::uint8_t(combined ^ white);
+        return;
+    }
+    if (color == black || color == white) {
+        constexpr std::array<std::uint8_t, 3> start{cyan, magenta, yellow};
+        color = start[seed % 3];
+        seed /= 3;
+        return;
+    }
+    auto const shifted = std::uint32_t(color) << (1 + (seed & 1));
+    color = std::uint8_t((shifted | shifted >> 3) & white);
+    seed >>= 1;
+}
+// Spread n edges over three colors, symmetric around the middle one.
+auto symmetrical_trichotomy(std::size_t position, std::size_t n) -> std::int32_t {
+    return std::int32_t(3.0 + 2.875 * double(position) / double(n - 1) - 1.4375 + 0.5) - 3;
+}
+
+auto degree(msdf_generator::edge const& e) -> std::size_t {
+    return e.type == msdf_generator::edge_type::line ? 1 : e.type == msdf_generator::edge_type::quadratic ? 2 : 3;
+}
+// De Casteljau with a parameter per level, equal parameters evaluate the curve.
+auto blossom(msdf_generator::edge const& e, std::array<float, 3> const& ts) -> glm::vec2 {
+    auto const n = degree(e);
+    auto p = e.points;
+    for (std::size_t level = 0; level < n; ++level) {
+        for (std::size_t i = 0; i < n - level; ++i)
+            p[i] = p[i] + (p[i + 1] - p[i]) * ts[level];
+    }
+    return p[0];
+}
+auto sub_edge(msdf_generator::edge const& e, float t0, float t1) -> msdf_generator::edge {
+    auto const n = degree(e);
+    auto result = e;
+    for (std::size_t k = 0; k <= n; ++k) {
+        std::array<float, 3> ts{};
+        for (std::size_t i = 0; i < n; ++i)
+            ts[i] = i < n - k ? t0 : t1;
+        result.points[k] = blossom(e, ts);
+    }
+    return result;
+}
+auto start_direction(msdf_generator::edge const& e) -> glm::vec2 {
+    auto const n = degree(e);
+    for (std::size_t i = 1; i <= n; ++i) {
+        if (e.points[i] != e.points[0]) return e.points[i] - e.points[0];
+    }
+    return {};
+}
+auto end_direction(msdf_generator::edge const& e) -> glm::vec2 {
+    auto const n = degree(e);
+    for (std::size_t i = n; i-- > 0;) {
+        if (e.points[i] != e.points[n]) return e.points[n] - e.points[i];
+    }
+    return {};
+}
+} // namespace
+
+struct msdf_outline_builder {
+    msdf_generator& generator;
+    glm::vec2       position{0.0f};
+    std::size_t     contour_start{0};
+
+    static auto point(FT_Vector const* v) -> glm::vec2 { return {float(v->x) / 64.0f, float(v->y) / 64.0f}; }
+    auto close() -> void {
+        auto const end = generator.m_edges.size();
+        if (end > contour_start) generator.m_contour_ends.push_back(end);
+        contour_start = end;
+    }
+    static auto move_to(FT_Vector const* to, void* user) -> int {
+        auto& self = *static_cast<msdf_outline_builder*>(user);
+        self.close();
+        self.position = point(to);
+        return 0;
+    }
+    static auto line_to(FT_Vector const* to, void* user) -> int {
+        auto& self = *static_cast<msdf_outline_builder*>(user);
+        auto const p = point(to);
+        if (p != self.position)
+            self.generator.m_edges.push_back({msdf_generator::edge_type::line, {self.position, p}, white});
+        self.position = p;
+        return 0;
+    }
+    static auto conic_to(FT_Vector const* control, FT_Vector const* to, void* user) -> int {
+        auto& self = *static_cast<msdf_outline_builder*>(user);
+        auto const p = point(to);
+        self.generator.m_edges.push_back({msdf_generator::edge_type::quadratic, {self.position, point(control), p}, white});
+        self.position = p;
+        return 0;
+    }
+    static auto cubic_to(FT_Vector const* control1, FT_Vector const* control2, FT_Vector const* to, void* user) -> int {
+        auto& self = *static_cast<msdf_outline_builder*>(user);
+        auto const p = point(to);
+        self.generator.m_edges.push_back({msdf_generator::edge_type::cubic, {self.position, point(control1), point(control2), p}, white});
+        self.position = p;
+        return 0;
+    }
+};
+
+auto msdf_generator::generate(FT_Outline* outline) -> bool {
+    m_width  = 0;
+    m_height = 0;
+    m_left   = 0;
+    m_top    = 0;
+    m_pixels.clear();
+    if (outline == nullptr) return false;
+    if (outline->n_contours == 0) return true;  // e.g. space
+    if (!decompose(outline)) return false;
+    if (m_edges.empty()) return true;
+
+    FT_BBox box{};
+    FT_Outline_Get_CBox(outline, &box);
+    auto const left   = std::int32_t(std::floor(float(box.xMin) / 64.0f)) - padding;
+    auto const right  = std::int32_t(std::ceil(float(box.xMax) / 64.0f)) + padding;
+    auto const bottom = std::int32_t(std::floor(float(box.yMin) / 64.0f)) - padding;
+    auto const top    = std::int32_t(std::ceil(float(box.yMax) / 64.0f)) + padding;
+    m_left   = left;
+    m_top    = top;
+    m_width  = std::uint32_t(right - left);
+    m_height = std::uint32_t(top - bottom);
+
+    color_edges();
+    flatten();
+    // TrueType outer contours run clockwise, PostScript ones counter-clockwise. Inside is positive.
+    auto const orientation = FT_Outline_Get_Orientation(outline) == FT_ORIENTATION_POSTSCRIPT ? 1.0f : -1.0f;
+    evaluate(orientation);
+    correct_clashes();
+
+    m_pixels.resize(m_field.size());
+    for (std::size_t i = 0; i < m_field.size(); ++i)
+        m_pixels[i] = std::uint8_t(std::clamp(m_field[i] * 255.0f + 0.5f, 0.0f, 255.0f));
+    return true;
+}
+
+auto msdf_generator::decompose(FT_Outline* outline) -> bool {
+    m_edges.clear();
+    m_contour_ends.clear();
+    FT_Outline_Funcs const funcs{
+        .move_to  = msdf_outline_builder::move_to,
+        .line_to  = msdf_outline_builder::line_to,
+        .conic_to = msdf_outline_builder::conic_to,
+        .cubic_to = msdf_outline_builder::cubic_to,
+        .shift    = 0,
+        .delta    = 0,
+    };
+    msdf_outline_builder builder{*this};
+    if (FT_Outline_Decompose(outline, &funcs, &builder)) return false;
+    builder.close();
+    return true;
+}
+
+auto msdf_generator::color_edges() -> void {
+    std::uint64_t seed = 0;
+    std::vector<edge> colored{};
+    colored.reserve(m_edges.size() + 6);
+    std::vector<std::size_t> ends{};
+    ends.reserve(m_contour_ends.size());
+    std::vector<std::size_t> corners{};
+
+    std::size_t begin = 0;
+    for (auto const end : m_contour_ends) {
+        auto const first = colored.size();
+        colored.insert(std::end(colored), std::begin(m_edges) + std::ptrdiff_t(begin), std::begin(m_edges) + std::ptrdiff_t(end));
+        begin = end;
+        auto count = colored.size() - first;
+
+        corners.clear();
+        auto previous = normalize(end_direction(colored.back()));
+        for (std::size_t i = 0; i < count; ++i) {
+            auto const& e = colored[first + i];
+            if (is_corner(previous, normalize(start_direction(e)))) corners.push_back(i);
+            previous = normalize(end_direction(e));
+        }
+
+        if (corners.empty()) {
+            // Smooth contour, every channel sees the same edges.
+            for (std::size_t i = 0; i < count; ++i)
+                colored[first + i].color = white;
+        } else if (corners.size() == 1) {
+            // Teardrop, spread three colors around the contour starting at the corner. Too few edges are
+            // split in thirds first so each color gets one.
+            if (count < 3) {
+                std::vector<edge> parts{};
+                for (std::size_t i = 0; i < count; ++i) {
+                    auto const& e = colored[first + (corners[0] + i) % count];
+                    parts.push_back(sub_edge(e, 0.0f, 1.0f / 3.0f));
+                    parts.push_back(sub_edge(e, 1.0f / 3.0f, 2.0f / 3.0f));
+                    parts.push_back(sub_edge(e, 2.0f / 3.0f, 1.0f));
+                }
+                colored.resize(first);
+                colored.insert(std::end(colored), std::begin(parts), std::end(parts));
+                count = parts.size();
+                corners[0] = 0;
+            }
+            std::array<std::uint8_t, 3> colors{white, white, white};
+            switch_color(colors[0], seed);
+            colors[2] = colors[0];
+            switch_color(colors[2], seed);
+            for (std::size_t i = 0; i < count; ++i)
+                colored[first + (corners[0] + i) % count].color = colors[std::size_t(1 + symmetrical_trichotomy(i, count))];
+        } else {
+            // Switch color at every corner, the last switch avoids the color the contour started with.
+            std::size_t spline = 0;
+            auto const start = corners[0];
+            std::uint8_t color = white;
+            switch_color(color, seed);
+            auto const initial = color;
+            for (std::size_t i = 0; i < count; ++i) {
+                auto const index = (start + i) % count;
+                if (spline + 1 < corners.size() && corners[spline + 1] == index) {
+                    ++spline;
+                    switch_color(color, seed, spline == corners.size() - 1 ? initial : black);
+                }
+                colored[first + index].color = color;
+            }
+        }
+        ends.push_back(colored.size());
+    }
+    m_edges.swap(colored);
+    m_contour_ends.swap(ends);
+}
+
+auto msdf_generator::flatten() -> void {
+    m_ax.clear();
+    m_ay.clear();
+    m_bx.clear();
+    m_by.clear();
+    m_dx.clear();
+    m_dy.clear();
+    m_inv_length2.clear();
+    m_color.clear();
+    m_extend.clear();
+
+    for (auto const& e : m_edges) {
+        auto const n = degree(e);
+        std::size_t count = 1;
+        if (n > 1) {
+            auto polygon = 0.0f;
+            for (std::size_t i = 0; i < n; ++i)
+                polygon += length(e.points[i + 1] - e.points[i]);
+            count = std::clamp(std::size_t(std::ceil(polygon / flatness)), std::size_t(2), max_curve_segments);
+        }
+        auto a = e.points[0];
+        for (std::size_t k = 0; k < count; ++k) {
+            auto const t = float(k + 1) / float(count);
+            auto const b = k + 1 == count ? e.points[n] : blossom(e, {t, t, t});
+            auto const d = b - a;
+            auto const length2 = dot(d, d);
+            if (length2 > 0.0f) {
+                m_ax.push_back(a.x);
+                m_ay.push_back(a.y);
+                m_bx.push_back(b.x);
+                m_by.push_back(b.y);
+                m_dx.push_back(d.x);
+                m_dy.push_back(d.y);
+                m_inv_length2.push_back(1.0f / length2);
+                m_color.push_back(e.color);
+                m_extend.push_back(std::uint8_t((k == 0 ? extend_start : 0) | (k + 1 == count ? extend_end : 0)));
+            }
+            a = b;
+        }
+    }
+}
+
+auto msdf_generator::evaluate(float orientation) -> void {
+    constexpr auto none = std::numeric_limits<std::size_t>::max();
+    auto const count = m_ax.size();
+    m_t.resize(count);
+    m_distance2.resize(count);
+    m_field.assign(std::size_t(m_width) * m_height * 3, 0.0f);
+
+    // How close to perpendicular the segment is seen from p, breaks ties at shared end points.
+    auto const orthogonality = [&](std::size_t k, float px, float py) {
+        auto const t = m_t[k];
+        if (t > 0.0f && t < 1.0f) return 0.0f;
+        auto const q = t <= 0.0f ? glm::vec2{m_ax[k], m_ay[k]} : glm::vec2{m_bx[k], m_by[k]};
+        return std::abs(dot(normalize({m_dx[k], m_dy[k]}), normalize(glm::vec2{px, py} - q)));
+    };
+
+    auto const* ax  = m_ax.data();
+    auto const* ay  = m_ay.data();
+    auto const* dx  = m_dx.data();
+    auto const* dy  = m_dy.data();
+    auto const* inv = m_inv_length2.data();
+    auto* ts        = m_t.data();
+    auto* distance2 = m_distance2.data();
+    for (std::uint32_t y = 0; y < m_height; ++y) {
+        auto const py = float(m_top) - float(y) - 0.5f;
+        for (std::uint32_t x = 0; x < m_width; ++x) {
+            auto const px = float(m_left) + float(x) + 0.5f;
+
+            // Closest point on every segment, no branches so it vectorizes.
+            for (std::size_t k = 0; k < count; ++k) {
+                auto const t  = std::min(std::max(((px - ax[k]) * dx[k] + (py - ay[k]) * dy[k]) * inv[k], 0.0f), 1.0f);
+                auto const qx = ax[k] + t * dx[k] - px;
+                auto const qy = ay[k] + t * dy[k] - py;
+                ts[k]        = t;
+                distance2[k] = qx * qx + qy * qy;
+            }
+
+            std::array<float, 3>       best{};
+            std::array<float, 3>       best_dot{-1.0f, -1.0f, -1.0f};  // Computed on the first tie only
+            std::array<std::size_t, 3> best_k{none, none, none};
+            best.fill(std::numeric_limits<float>::max());
+            for (std::size_t k = 0; k < count; ++k) {
+                auto const d2 = distance2[k];
+                for (std::size_t ch = 0; ch < 3; ++ch) {
+                    if ((m_color[k] & (1u << ch)) == 0) continue;
+                    if (d2 < best[ch] * (1.0f - tie_epsilon)) {
+                        best[ch]     = d2;
+                        best_dot[ch] = -1.0f;
+                        best_k[ch]   = k;
+                    } else if (d2 <= best[ch] * (1.0f + tie_epsilon)) {
+                        if (best_dot[ch] < 0.0f) best_dot[ch] = orthogonality(best_k[ch], px, py);
+                        auto const o = orthogonality(k, px, py);
+                        if (o < best_dot[ch]) {
+                            best[ch]     = d2;
+                            best_dot[ch] = o;
+                            best_k[ch]   = k;
+                        }
+                    }
+                }
+            }
+
+            auto* pixel = &m_field[(std::size_t(y) * m_width + x) * 3];
+            for (std::size_t ch = 0; ch < 3; ++ch) {
+                auto const k = best_k[ch];
+                if (k == none) continue;  // Channel without edges stays outside
+                auto const side = dx[k] * (py - ay[k]) - dy[k] * (px - ax[k]);
+                auto distance = 0.0f;
+                auto const t = ts[k];
+                if ((t <= 0.0f && (m_extend[k] & extend_start)) || (t >= 1.0f && (m_extend[k] & extend_end)))
+                    distance = side * std::sqrt(inv[k]);  // Pseudo-distance to the edge extended past its end
+                else
+                    distance = side < 0.0f ? -std::sqrt(best[ch]) : std::sqrt(best[ch]);
+                pixel[ch] = orientation * distance / msdf_range + 0.5f;
+            }
+        }
+    }
+}
+
+auto msdf_generator::correct_clashes() -> void {
+    // Neighbouring texels can't differ by more than a pixel of distance, a larger jump in a channel that
+    // is not the median is interpolated into artifacts. Such texels are flattened to their median.
+    auto const threshold = 1.001f / msdf_range;
+    auto const clash = [&](float const* a, float const* b) {
+        // Sort channels so pairs go from the largest to the smallest difference.
+        auto a0 = a[0], a1 = a[1], a2 = a[2];
+        auto b0 = b[0], b1 = b[1], b2 = b[2];
+        if (std::abs(b0 - a0) < std::abs(b1 - a1)) {
+            std::swap(a0, a1);
+            std::swap(b0, b1);
+        }
+        if (std::abs(b1 - a1) < std::abs(b2 - a2)) {
+            std::swap(a1, a2);
+            std::swap(b1, b2);
+            if (std::abs(b0 - a0) < std::abs(b1 - a1)) {
+                std::swap(a0, a1);
+                std::swap(b0, b1);
+            }
+        }
+        return std::abs(b1 - a1) >= threshold
+            && !(b0 == b1 && b0 == b2)                     // Neighbour already equalized
+            && std::abs(a2 - 0.5f) >= std::abs(b2 - 0.5f);  // Only the texel farther from the edge
+    };
+
+    auto const at = [&](std::uint32_t x, std::uint32_t y) { return &m_field[(std::size_t(y) * m_width + x) * 3]; };
+    std::vector<std::size_t> clashes{};
+    for (std::uint32_t y = 0; y < m_height; ++y) {
+        for (std::uint32_t x = 0; x < m_width; ++x) {
+            auto const* p = at(x, y);
+            if ((x > 0 && clash(p, at(x - 1, y)))
+             || (x + 1 < m_width && clash(p, at(x + 1, y)))
+             || (y > 0 && clash(p, at(x, y - 1)))
+             || (y + 1 < m_height && clash(p, at(x, y + 1))))
+                clashes.push_back(std::size_t(y) * m_width + x);
+        }
+    }
+    for (auto const index : clashes) {
+        auto* p = &m_field[index * 3];
+        p[0] = p[1] = p[2] = median(p[0], p[1], p[2]);
+    }
+}
+} // namespace txt
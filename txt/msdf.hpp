@@ -0,0 +1,80 @@
+#ifndef TXT_MSDF_HPP
+#define TXT_MSDF_HPP
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+
+#include "ft2build.h"
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+
+#include "glm/vec2.hpp"
+
+namespace txt {
+// Distance in pixels spanned by the 0..1 range of a channel, half of it on each side of the outline.
+constexpr float msdf_range{4.0f};
+
+// Multi-channel signed distance field generator for FreeType outlines. Edges are colored so the two
+// sides of every corner land in different channels, the median of the channels reconstructs the sharp
+// corner in the shader. Curves are flattened into line segments kept as structure of arrays, so the
+// distance loop over segments vectorizes. Scratch buffers are reused between glyphs, one generator per
+// thread.
+class msdf_generator {
+public:
+    msdf_generator() = default;
+    ~msdf_generator() = default;
+
+    // Outline in 26.6 pixel units, as loaded without FT_LOAD_RENDER. An empty outline gives an empty field.
+    auto generate(FT_Outline* outline) -> bool;
+
+    auto width() const -> std::uint32_t { return m_width; }
+    auto height() const -> std::uint32_t { return m_height; }
+    auto left() const -> std::int32_t { return m_left; }
+    auto top() const -> std::int32_t { return m_top; }
+    auto pixels() const -> std::vector<std::uint8_t> const& { return m_pixels; }  // Top-down RGB rows
+
+    // Outline edge, points past the degree of the edge are unused. Color is a mask of RGB channels.
+    enum class edge_type : std::uint8_t { line, quadratic, cubic };
+    struct edge {
+        edge_type                type;
+        std::array<glm::vec2, 4> points;
+        std::uint8_t             color;
+    };
+
+private:
+    friend struct msdf_outline_builder;
+    auto decompose(FT_Outline* outline) -> bool;
+    auto color_edges() -> void;
+    auto flatten() -> void;
+    auto evaluate(float orientation) -> void;
+    auto correct_clashes() -> void;
+
+private:
+    std::uint32_t m_width{0};
+    std::uint32_t m_height{0};
+    std::int32_t  m_left{0};
+    std::int32_t  m_top{0};
+
+    std::vector<edge>        m_edges{};
+    std::vector<std::size_t> m_contour_ends{};  // One past the last edge of every contour
+
+    // Flattened segments from a to b, direction d = b - a.
+    std::vector<float>        m_ax{};
+    std::vector<float>        m_ay{};
+    std::vector<float>        m_bx{};
+    std::vector<float>        m_by{};
+    std::vector<float>        m_dx{};
+    std::vector<float>        m_dy{};
+    std::vector<float>        m_inv_length2{};
+    std::vector<std::uint8_t> m_color{};
+    std::vector<std::uint8_t> m_extend{};  // Segment starts or ends an edge, pseudo-distance extends past it
+    std::vector<float>        m_t{};       // Per pixel scratch
+    std::vector<float>        m_distance2{};
+
+    std::vector<float>        m_field{};
+    std::vector<std::uint8_t> m_pixels{};
+};
+} // namespace txt
+
+#endif  // TXT_MSDF_HPP
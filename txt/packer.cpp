@@ -0,0 +1,154 @@
+#include "packer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "fmt/format.h"
+
+namespace txt {
+// Non power of two textures are fine on GL 4.1 and WebGL 2, align to 64 to keep rows friendly.
+static auto align_up(double const& value) -> std::size_t {
+    return (static_cast<std::size_t>(std::ceil(value)) + 63) / 64 * 64;
+}
+
+skyline_packer::skyline_packer(std::size_t width, std::size_t height, std::size_t padding)
+    : m_width(width)
+    , m_height(height)
+    , m_padding(padding) {
+    reset(width, height);
+}
+
+auto skyline_packer::occupancy() const -> float {
+    if (m_width == 0 || m_height == 0) return 0.0f;
+    return float(double(m_used_area) / double(m_width * m_height));
+}
+
+auto skyline_packer::reset(std::size_t width, std::size_t height) -> void {
+    m_width     = width;
+    m_height    = height;
+    m_used_area = 0;
+    m_skyline.clear();
+    if (m_width > 0) m_skyline.push_back({0, 0, std::int32_t(m_width)});
+}
+
+auto skyline_packer::pack(std::size_t width, std::size_t height) -> std::optional<glm::ivec2> {
+    if (width == 0 || height == 0) return glm::ivec2{0, 0};  // Nothing to store, e.g. space
+    auto const w = std::int32_t(width + m_padding);
+    auto const h = std::int32_t(height + m_padding);
+
+    std::size_t best_index = m_skyline.size();
+    std::int32_t best_top   = std::numeric_limits<std::int32_t>::max();
+    std::int32_t best_width = std::numeric_limits<std::int32_t>::max();
+    for (std::size_t i = 0; i < m_skyline.size(); ++i) {
+        auto const y = fit(i, w, h);
+        if (!y.has_value()) continue;
+        auto const top = *y + h;
+        if (top < best_top || (top == best_top && m_skyline[i].width < best_width)) {
+            best_index = i;
+            best_top   = top;
+            best_width = m_skyline[i].width;
+        }
+    }
+    if (best_index == m_skyline.size()) return std::nullopt;
+
+    glm::ivec2 const position{m_skyline[best_index].x, best_top - h};
+    raise(position.x, best_top, w);
+    m_used_area += width * height;
+    return position;
+}
+
+auto skyline_packer::occupy(glm::ivec2 const& position, std::size_t width, std::size_t height) -> void {
+    if (width == 0 || height == 0) return;
+    raise(position.x, position.y + std::int32_t(height + m_padding), std::int32_t(width + m_padding));
+    m_used_area += width * height;
+}
+
+auto skyline_packer::fit(std::size_t index, std::int32_t width, std::int32_t height) const -> std::optional<std::int32_t> {
+    auto const x = m_skyline[index].x;
+    if (x + width > std::int32_t(m_width)) return std::nullopt;
+    // The rectangle rests on the highest segment below its span.
+    std::int32_t y = 0;
+    std::int32_t remaining = width;
+    for (auto i = index; remaining > 0 && i < m_skyline.size(); ++i) {
+        y = std::max(y, m_skyline[i].y);
+        remaining -= m_skyline[i].width;
+    }
+    if (y + height > std::int32_t(m_height)) return std::nullopt;
+    return y;
+}
+
+auto skyline_packer::raise(std::int32_t x, std::int32_t top, std::int32_t width) -> void {
+    auto const right = std::min(x + width, std::int32_t(m_width));
+    std::vector<segment> skyline{};
+    skyline.reserve(m_skyline.size() + 2);
+    auto const append = [&](std::int32_t sx, std::int32_t sy, std::int32_t sw) {
+        if (sw <= 0) return;
+        // Merge neighbours of equal height to keep the skyline short.
+        if (!skyline.empty() && skyline.back().y == sy)
+            skyline.back().width += sw;
+        else
+            skyline.push_back({sx, sy, sw});
+    };
+    for (auto const& s : m_skyline) {
+        auto const s_right = s.x + s.width;
+        auto const inner_left  = std::clamp(s.x, x, right);
+        auto const inner_right = std::clamp(s_right, x, right);
+        append(s.x, s.y, std::min(s_right, x) - s.x);
+        append(inner_left, std::max(top, s.y), inner_right - inner_left);
+        append(std::max(s.x, right), s.y, s_right - std::max(s.x, right));
+    }
+    m_skyline = std::move(skyline);
+}
+
+auto layout_atlas(std::vector<glm::ivec2> const& sizes, std::size_t padding, std::size_t min_size, std::size_t limit) -> atlas_layout {
+    // Tallest first keeps the skyline flat, which wastes less space under it.
+    std::vector<std::size_t> order(sizes.size());
+    std::iota(std::begin(order), std::end(order), std::size_t(0));
+    std::sort(std::begin(order), std::end(order), [&](std::size_t a, std::size_t b) {
+        if (sizes[a].y != sizes[b].y) return sizes[a].y > sizes[b].y;
+        return sizes[a].x > sizes[b].x;
+    });
+
+    std::size_t area = 0;
+    std::size_t max_side = 0;
+    for (auto const& size : sizes) {
+        auto const w = std::size_t(size.x) + padding;
+        auto const h = std::size_t(size.y) + padding;
+        area += w * h;
+        max_side = std::max(max_side, std::max(w, h));
+    }
+    if (max_side > limit)
+        throw std::runtime_error(fmt::format("Glyph of {} pixels doesn't fit an atlas page of {}!", max_side, limit));
+
+    // Sorted input packs to roughly 90% of the area, start with some slack and grow in small steps.
+    atlas_layout layout{};
+    layout.page_size = std::min(std::max({align_up(std::sqrt(double(area) * 1.1)), align_up(double(max_side)), align_up(double(min_size))}), limit);
+    auto const restart = [&] {
+        layout.packers.assign(1, skyline_packer{layout.page_size, layout.page_size, padding});
+        layout.positions.assign(sizes.size(), glm::ivec3{0});
+    };
+    restart();
+    for (std::size_t i = 0; i < order.size();) {
+        auto const& size = sizes[order[i]];
+        auto placed = false;
+        for (std::size_t page = 0; page < layout.packers.size() && !placed; ++page) {
+            auto const position = layout.packers[page].pack(std::size_t(size.x), std::size_t(size.y));
+            if (!position.has_value()) continue;
+            layout.positions[order[i]] = {*position, std::int32_t(page)};
+            placed = true;
+        }
+        if (placed) {
+            ++i;
+        } else if (layout.page_size < limit) {
+            layout.page_size = std::min(align_up(double(layout.page_size) * 1.125), limit);
+            restart();
+            i = 0;
+        } else {
+            layout.packers.emplace_back(layout.page_size, layout.page_size, padding);
+        }
+    }
+    return layout;
+}
+} // namespace txt
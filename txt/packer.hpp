@@ -0,0 +1,67 @@
+#ifndef TXT_PACKER_HPP
+#define TXT_PACKER_HPP
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <optional>
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+namespace txt {
+// Padding between atlas glyphs, a cached atlas is only adopted when it was packed with the same.
+inline constexpr std::size_t atlas_padding = 1;
+// Largest atlas page, full atlases grow by another page of this size instead of being reallocated.
+inline constexpr std::size_t atlas_page_size = 2048;
+
+// Bottom-left skyline rectangle packer. The skyline is the upper contour of everything placed so far,
+// a new rectangle goes where its top edge ends up lowest. Origin is the bottom-left corner, same as
+// the texture coordinates of the atlas.
+class skyline_packer {
+public:
+    skyline_packer(std::size_t width = 0, std::size_t height = 0, std::size_t padding = 0);
+    ~skyline_packer() = default;
+
+    auto width() const -> std::size_t { return m_width; }
+    auto height() const -> std::size_t { return m_height; }
+    auto padding() const -> std::size_t { return m_padding; }
+    auto used_area() const -> std::size_t { return m_used_area; }
+    // Fraction of the area covered by packed rectangles, padding not included.
+    auto occupancy() const -> float;
+
+    auto reset(std::size_t width, std::size_t height) -> void;
+    auto pack(std::size_t width, std::size_t height) -> std::optional<glm::ivec2>;
+    // Mark an already placed rectangle as used, e.g. when restoring an atlas from disk.
+    auto occupy(glm::ivec2 const& position, std::size_t width, std::size_t height) -> void;
+
+private:
+    struct segment {
+        std::int32_t x;
+        std::int32_t y;
+        std::int32_t width;
+    };
+
+    auto fit(std::size_t index, std::int32_t width, std::int32_t height) const -> std::optional<std::int32_t>;
+    auto raise(std::int32_t x, std::int32_t top, std::int32_t width) -> void;
+
+private:
+    std::size_t          m_width;
+    std::size_t          m_height;
+    std::size_t          m_padding;
+    std::size_t          m_used_area{0};
+    std::vector<segment> m_skyline{};
+};
+
+struct atlas_layout {
+    std::size_t                 page_size{0};
+    std::vector<skyline_packer> packers{};    // One per page
+    std::vector<glm::ivec3>     positions{};  // Per rectangle in the order given, z is the page
+};
+
+// Square pages of at least min_size, tallest first into one page grown up to limit, the rest spills over
+// into more pages of that size. The text engine and txt-bake both lay out atlases with this, so a baked
+// atlas matches the one the engine would pack.
+auto layout_atlas(std::vector<glm::ivec2> const& sizes, std::size_t padding, std::size_t min_size, std::size_t limit) -> atlas_layout;
+} // namespace txt
+
+#endif  // TXT_PACKER_HPP
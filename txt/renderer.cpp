@@ -48,12 +48,45 @@ auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotatio
 auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotation, texture_ref_t texture, glm::vec2 const& uv, glm::vec2 const& uv_size, glm::vec4 const& round) -> void {
     s_instance->rect(position, size, rotation, texture, uv, uv_size, round);
 }
-auto text(std::string const& str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void {
+auto text(std::string_view str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void {
     s_instance->text(str, position, color, scale, tf);
 }
-auto text_size(std::string const& str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
+auto text(std::u8string_view str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void {
+    s_instance->text(as_string_view(str), position, color, scale, tf);
+}
+auto text_size(std::string_view str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
     return s_instance->text_size(str, scale, typeface);
 }
+auto text_size(std::u8string_view str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
+    return s_instance->text_size(as_string_view(str), scale, typeface);
+}
+auto layout(text_layout& layout, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return s_instance->layout(layout, str, props, typeface);
+}
+auto layout(text_layout& layout, std::u8string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return s_instance->layout(layout, as_string_view(str), props, typeface);
+}
+auto text(text_layout& layout, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    s_instance->text(layout, position, color, scale);
+}
+auto text(text_document& document, std::size_t first, std::size_t count, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    s_instance->text(document, first, count, position, color, scale);
+}
+auto text(text_document& document, float scroll, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    s_instance->text(document, scroll, position, color, scale);
+}
+auto layout(text_object& object, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return s_instance->layout(object, str, props, typeface);
+}
+auto layout(text_object& object, std::u8string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return s_instance->layout(object, as_string_view(str), props, typeface);
+}
+auto text(text_object& object) -> void {
+    s_instance->text(object);
+}
+auto text(cell_grid& grid, glm::vec2 const& position, glm::vec2 const& scale) -> void {
+    s_instance->text(grid, position, scale);
+}
 
 auto renderer::begin() -> void {
     m_view = glm::lookAt(glm::vec3{0.0, 0.0, 1023.0}, glm::vec3{0.0, 0.0, 0.0}, glm::vec3{0.0, 1.0, 0.0});
@@ -163,12 +196,38 @@ auto renderer::rect(glm::vec2 const& position, glm::vec2 const& size, float cons
     m_depth += m_depth_step;
 }
 
-auto renderer::text(std::string const& str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void {
+auto renderer::text(std::string_view str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void {
     m_text_engine->text(str, {position, m_depth}, color, scale, tf);
     m_depth += m_depth_step;
 }
 
-auto renderer::text_size(std::string const& str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
+auto renderer::layout(text_layout& layout, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return m_text_engine->layout(layout, str, props, typeface);
+}
+auto renderer::text(text_layout& layout, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    m_text_engine->text(layout, {position, m_depth}, color, scale);
+    m_depth += m_depth_step;
+}
+auto renderer::text(text_document& document, std::size_t first, std::size_t count, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    m_text_engine->text(document, first, count, {position, m_depth}, color, scale);
+    m_depth += m_depth_step;
+}
+auto renderer::text(text_document& document, float scroll, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    m_text_engine->text(document, scroll, {position, m_depth}, color, scale);
+    m_depth += m_depth_step;
+}
+auto renderer::layout(text_object& object, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return m_text_engine->layout(object, str, props, typeface);
+}
+auto renderer::text(text_object& object) -> void {
+    m_text_engine->text(object, m_depth);
+    m_depth += m_depth_step;
+}
+auto renderer::text(cell_grid& grid, glm::vec2 const& position, glm::vec2 const& scale) -> void {
+    m_text_engine->text(grid, {position, m_depth}, scale);
+    m_depth += m_depth_step;
+}
+auto renderer::text_size(std::string_view str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
     return m_text_engine->text_size(str, scale, typeface);
 }
 
@@ -177,6 +236,14 @@ auto renderer::load_font(typeface_props const& props) -> typeface_ref_t {
     m_text_engine->reload();
     return m_text_engine->fonts()->family(props.family)->typeface(props.style);
 }
+auto renderer::load_font_pack(std::string const& filename, std::string const& family, std::string const& style) -> typeface_ref_t {
+    m_text_engine->fonts()->load_pack(filename, family, style);
+    m_text_engine->reload();
+    return m_text_engine->fonts()->family(family)->typeface(style);
+}
+auto renderer::load_font_async(typeface_props const& props) -> font_handle_ref_t {
+    return m_text_engine->load_async(props);
+}
 auto renderer::family(std::string const& family) -> font_family_ref_t {
     return m_text_engine->fonts()->family(family);
 }
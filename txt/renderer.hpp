@@ -4,6 +4,7 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <string_view>
 
 #include "utility.hpp"
 #include "window.hpp"
@@ -12,6 +13,7 @@
 #include "texture.hpp"
 #include "fonts.hpp"
 #include "text_engine.hpp"
+#include "unicode.hpp"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
@@ -32,8 +34,19 @@ auto clear_color(std::uint32_t color, float alpha = 1.0f) -> void;
 auto clear(GLenum bitmask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT) -> void;
 auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotation = 0.0f, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec4 const& round = {}) -> void;
 auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotation, texture_ref_t texture, glm::vec2 const& uv = {0.0f, 0.0f}, glm::vec2 const& uv_size = {1.0f, 1.0f}, glm::vec4 const& round = {0.0f, 0.0f, 0.0f, 0.0f}) -> void;
-auto text(std::string const& str, glm::vec2 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& tf = nullptr) -> void;
-auto text_size(std::string const& str, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> glm::vec2;
+auto text(std::string_view str, glm::vec2 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& tf = nullptr) -> void;
+auto text(std::u8string_view str, glm::vec2 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& tf = nullptr) -> void;
+auto text_size(std::string_view str, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> glm::vec2;
+auto text_size(std::u8string_view str, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> glm::vec2;
+auto layout(text_layout& layout, std::string_view str, layout_props const& props = {}, typeface_ref_t const& typeface = nullptr) -> bool;
+auto layout(text_layout& layout, std::u8string_view str, layout_props const& props = {}, typeface_ref_t const& typeface = nullptr) -> bool;
+auto text(text_layout& layout, glm::vec2 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+auto text(text_document& document, std::size_t first, std::size_t count, glm::vec2 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+auto text(text_document& document, float scroll, glm::vec2 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+auto layout(text_object& object, std::string_view str, layout_props const& props = {}, typeface_ref_t const& typeface = nullptr) -> bool;
+auto layout(text_object& object, std::u8string_view str, layout_props const& props = {}, typeface_ref_t const& typeface = nullptr) -> bool;
+auto text(text_object& object) -> void;
+auto text(cell_grid& grid, glm::vec2 const& position, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
 
 struct rect_instance {
     glm::vec4 color{0.0f};
@@ -87,9 +100,21 @@ class renderer {
     auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotation, glm::vec4 const& color, glm::vec4 const& round) -> void;
     auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotation, texture_ref_t texture, glm::vec2 const& uv, glm::vec2 const& uv_size, glm::vec4 const& round) -> void;
     auto rect(glm::vec2 const& position, glm::vec2 const& size, float const& rotation, shader_ref_t shader, texture_ref_t texture, glm::vec2 const& uv, glm::vec2 const& uv_size, [[maybe_unused]] glm::vec4 const& round) -> void;
-    auto text(std::string const& str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void;
-    auto text_size(std::string const& str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2;
+    auto text(std::string_view str, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& tf) -> void;
+    auto text_size(std::string_view str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2;
+    auto layout(text_layout& layout, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool;
+    auto text(text_layout& layout, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void;
+    auto text(text_document& document, std::size_t first, std::size_t count, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void;
+    auto text(text_document& document, float scroll, glm::vec2 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void;
+    auto layout(text_object& object, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool;
+    // Draws with the object's own position, color and scale at the current depth.
+    auto text(text_object& object) -> void;
+    // Position is the grid's top left corner.
+    auto text(cell_grid& grid, glm::vec2 const& position, glm::vec2 const& scale) -> void;
     auto load_font(typeface_props const& props) -> typeface_ref_t;
+    // Returns at once, the font is usable from the first begin() after the handle is ready.
+    auto load_font_async(typeface_props const& props) -> font_handle_ref_t;
+    auto load_font_pack(std::string const& filename, std::string const& family, std::string const& style) -> typeface_ref_t;
     auto family(std::string const& family) -> font_family_ref_t;
     auto typeface(std::string const& family, std::string const& style) -> typeface_ref_t;
     auto fonts() -> font_manager_ref_t;
@@ -0,0 +1,65 @@
+#include "shaping.hpp"
+#include "unicode.hpp"
+
+namespace txt {
+auto shape(typeface& face, std::string_view str, shaped_run& run) -> void {
+    run.indices.clear();
+    run.offsets.clear();
+    run.advance = 0;
+
+    std::int64_t  pen = 0;
+    std::uint32_t previous = 0;
+    for_each_codepoint(str, [&](std::uint32_t code) {
+        auto const index = face.index(code);
+        if (!run.indices.empty()) pen += face.kerning(previous, code);
+        run.indices.push_back(index);
+        run.offsets.push_back(pen);
+        // Looked up after index(), loading a glyph may grow the metrics.
+        pen += face.metrics().advance_x[index];
+        previous = code;
+    });
+    run.advance = pen;
+}
+
+shaped_run_cache::shaped_run_cache(std::size_t capacity) : m_capacity(std::max(capacity, std::size_t(1))) {
+    m_lookup.reserve(m_capacity);
+}
+
+auto shaped_run_cache::get(typeface_ref_t const& face, std::string_view str) -> shaped_run const& {
+    auto const key = fnv1a_value(face.get(), fnv1a(str.data(), str.size()));
+    auto const it  = m_lookup.find(key);
+    if (it != std::end(m_lookup)) {
+        auto& e = *it->second;
+        m_entries.splice(std::begin(m_entries), m_entries, it->second);
+        if (e.text == str && e.face.lock() == face && e.generation == face->generation())
+            return e.run;
+        // Typeface changed or a hash collision, shape again in place.
+        shape(*face, str, e.run);
+        e.text.assign(str);
+        e.face       = face;
+        e.generation = face->generation();
+        return e.run;
+    }
+
+    // Recycle the least recently used entry once full, its buffers are reused.
+    if (m_entries.size() >= m_capacity) {
+        m_lookup.erase(m_entries.back().key);
+        m_entries.splice(std::begin(m_entries), m_entries, std::prev(std::end(m_entries)));
+    } else {
+        m_entries.emplace_front();
+    }
+    auto& e = m_entries.front();
+    e.key = key;
+    e.text.clear();  // Matches nothing until shaped
+    shape(*face, str, e.run);
+    e.text.assign(str);
+    e.face       = face;
+    e.generation = face->generation();
+    m_lookup.insert({key, std::begin(m_entries)});
+    return e.run;
+}
+auto shaped_run_cache::clear() -> void {
+    m_lookup.clear();
+    m_entries.clear();
+}
+} // namespace txt
@@ -0,0 +1,58 @@
+#ifndef TXT_SHAPING_HPP
+#define TXT_SHAPING_HPP
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utility.hpp"
+#include "fonts.hpp"
+
+namespace txt {
+// Glyphs of a shaped string. Indices are the typeface's dense glyph indices, offsets are the pen
+// position of every glyph in 26.6 pixels relative to the start of the run, kerning included.
+struct shaped_run {
+    std::vector<std::uint32_t> indices{};
+    std::vector<std::int64_t>  offsets{};
+    std::int64_t               advance{0};
+
+    auto size() const -> std::size_t { return indices.size(); }
+};
+
+// Decode, look up and kern str into run, the run's buffers are reused.
+auto shape(typeface& face, std::string_view str, shaped_run& run) -> void;
+
+// Least recently used cache of shaped runs, so strings drawn every frame are only shaped once. Runs are
+// unscaled and shared by every scale, an entry is shaped again when its typeface changed since.
+class shaped_run_cache {
+public:
+    shaped_run_cache(std::size_t capacity = 1024);
+    ~shaped_run_cache() = default;
+
+    auto size() const -> std::size_t { return m_entries.size(); }
+    auto capacity() const -> std::size_t { return m_capacity; }
+    // The reference is valid until the next call.
+    auto get(typeface_ref_t const& face, std::string_view str) -> shaped_run const&;
+    auto clear() -> void;
+
+private:
+    struct entry {
+        std::uint64_t   key;
+        std::string     text;
+        weak<typeface>  face;
+        std::uint64_t   generation;
+        shaped_run      run;
+    };
+    using entry_list = std::list<entry>;
+
+private:
+    std::size_t m_capacity;
+    entry_list  m_entries{};  // Most recently used first
+    std::unordered_map<std::uint64_t, entry_list::iterator> m_lookup{};
+};
+} // namespace txt
+
+#endif  // TXT_SHAPING_HPP
@@ -0,0 +1,232 @@
+#include "text_document.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace txt {
+// The append buffer is rewritten with only the live spans once it is mostly garbage.
+static constexpr std::size_t min_compact_bytes = 64 * 1024;
+
+text_document::text_document(std::string text, std::size_t layout_capacity)
+    : m_original_text(std::move(text))
+    , m_layout_capacity(std::max(layout_capacity, std::size_t(1))) {
+    m_original = m_original_text;
+    split_lines(m_original);
+}
+text_document::text_document(mapped_file_ref_t file, std::size_t layout_capacity)
+    : m_file(std::move(file))
+    , m_layout_capacity(std::max(layout_capacity, std::size_t(1))) {
+    m_original = {reinterpret_cast<char const*>(m_file->data()), m_file->size()};
+    split_lines(m_original);
+}
+
+auto text_document::split_lines(std::string_view text) -> void {
+    m_lines.reserve(std::size_t(std::count(std::begin(text), std::end(text), '\n')) + 1);
+    std::size_t start = 0;
+    while (true) {
+        auto const end = text.find('\n', start);
+        auto const length = (end == std::string_view::npos ? text.size() : end) - start;
+        m_lines.push_back({.start = start, .length = std::uint32_t(length), .height = 0.0f, .added = false, .id = m_next_id++});
+        if (end == std::string_view::npos) break;
+        start = end + 1;
+    }
+}
+
+auto text_document::line(std::size_t index) const -> std::string_view {
+    return view(m_lines[index]);
+}
+auto text_document::text() const -> std::string {
+    std::string str{};
+    for (std::size_t i = 0; i < m_lines.size(); ++i) {
+        if (i > 0) str.push_back('\n');
+        str.append(view(m_lines[i]));
+    }
+    return str;
+}
+
+auto text_document::insert(text_position const& at, std::string_view str) -> text_position {
+    if (at.line >= m_lines.size()) throw std::runtime_error(fmt::format("Line {} is past the end of the document!", at.line));
+    auto const base   = m_lines[at.line];
+    auto const column = std::min<std::size_t>(at.column, base.length);
+    if (str.empty()) return {at.line, column};
+
+    auto const breaks = std::size_t(std::count(std::begin(str), std::end(str), '\n'));
+    if (breaks == 0) {
+        auto const text = view(base);
+        m_scratch.assign(text.substr(0, column));
+        m_scratch.append(str);
+        m_scratch.append(text.substr(column));
+        assign(at.line, append(m_scratch, {}));
+        compact();
+        return {at.line, column + str.size()};
+    }
+
+    // Lines in between are spans of a single copy of str, only the first and last are concatenated.
+    auto const copy = append(str, {});
+    std::vector<piece> added{};
+    added.reserve(breaks);
+    auto const first_end = str.find('\n');
+    auto const last_begin = str.rfind('\n') + 1;
+    for (auto start = first_end + 1; start < last_begin;) {
+        auto const end = str.find('\n', start);
+        added.push_back(sub(copy, start, end - start));
+        start = end + 1;
+    }
+    auto const last_part = str.substr(last_begin);
+    auto const suffix = last_part.empty()
+        ? sub(base, column, base.length - column)
+        : append(last_part, view(base).substr(column));
+    added.push_back(suffix);
+    auto const head = first_end == 0 ? sub(base, 0, column) : append(view(base).substr(0, column), str.substr(0, first_end));
+
+    for (auto& p : added) {
+        p.id = m_next_id++;
+        if (p.added) m_added_live += p.length;
+    }
+    m_lines.insert(std::next(std::begin(m_lines), std::ptrdiff_t(at.line + 1)), std::begin(added), std::end(added));
+    assign(at.line, head);
+    invalidate_tops(at.line);
+    compact();
+    return {at.line + breaks, last_part.size()};
+}
+auto text_document::erase(text_position const& from, text_position const& to) -> void {
+    auto first = from;
+    auto last  = to;
+    if (last.line < first.line || (last.line == first.line && last.column < first.column)) std::swap(first, last);
+    if (last.line >= m_lines.size()) throw std::runtime_error(fmt::format("Line {} is past the end of the document!", last.line));
+
+    auto const head = m_lines[first.line];
+    auto const tail = m_lines[last.line];
+    auto const head_column = std::min<std::size_t>(first.column, head.length);
+    auto const tail_column = std::min<std::size_t>(last.column, tail.length);
+    if (first.line == last.line && head_column >= tail_column) return;
+
+    piece joined{};
+    if (head_column == 0)
+        joined = sub(tail, tail_column, tail.length - tail_column);
+    else if (tail_column == tail.length)
+        joined = sub(head, 0, head_column);
+    else
+        joined = append(view(head).substr(0, head_column), view(tail).substr(tail_column));
+
+    auto const begin = std::next(std::begin(m_lines), std::ptrdiff_t(first.line + 1));
+    auto const end   = std::next(std::begin(m_lines), std::ptrdiff_t(last.line + 1));
+    for (auto it = begin; it != end; ++it) {
+        if (it->added) m_added_live -= it->length;
+    }
+    m_lines.erase(begin, end);
+    assign(first.line, joined);
+    invalidate_tops(first.line);
+    compact();
+}
+
+auto text_document::set_layout(typeface_ref_t const& face, layout_props const& props) -> void {
+    auto const same_props = props.max_width == m_props.max_width && props.align == m_props.align && props.line_spacing == m_props.line_spacing;
+    if (face == m_typeface && same_props) return;
+    m_typeface = face;
+    m_props    = props;
+    m_layout_lookup.clear();
+    m_layouts.clear();
+    for (auto& line : m_lines) line.height = 0.0f;
+    invalidate_tops(0);
+}
+auto text_document::layout(std::size_t index) -> text_layout& {
+    if (m_typeface == nullptr) throw std::runtime_error("Text document has no typeface to lay out with!");
+    auto const id = m_lines[index].id;
+    if (auto const it = m_layout_lookup.find(id); it != std::end(m_layout_lookup)) {
+        m_layouts.splice(std::begin(m_layouts), m_layouts, it->second);
+        auto& layout = it->second->layout;
+        if (layout.refresh()) measure(index, layout);
+        return layout;
+    }
+
+    // Recycle the least recently used layout once full, its buffers are reused.
+    if (m_layouts.size() >= m_layout_capacity) {
+        m_layout_lookup.erase(m_layouts.back().id);
+        m_layouts.splice(std::begin(m_layouts), m_layouts, std::prev(std::end(m_layouts)));
+    } else {
+        m_layouts.emplace_front();
+    }
+    auto& entry = m_layouts.front();
+    entry.id = id;
+    entry.layout.update(m_typeface, view(m_lines[index]), m_props);
+    m_layout_lookup.insert({id, std::begin(m_layouts)});
+    measure(index, entry.layout);
+    return entry.layout;
+}
+
+auto text_document::row_height() -> float {
+    if (m_typeface == nullptr) throw std::runtime_error("Text document has no typeface to lay out with!");
+    auto& face = *m_typeface;
+    auto const index = face.index(' ');
+    return float(face.glyphs()[index].advance_y) * face.layout_scale() / 64.0f;
+}
+auto text_document::line_top(std::size_t index) -> float {
+    update_tops();
+    return m_tops[index];
+}
+auto text_document::line_at(float offset) -> std::size_t {
+    update_tops();
+    auto const it = std::upper_bound(std::next(std::begin(m_tops)), std::end(m_tops), offset);
+    auto const index = std::size_t(std::distance(std::next(std::begin(m_tops)), it));
+    return std::min(index, m_lines.size() - 1);
+}
+
+auto text_document::view(piece const& p) const -> std::string_view {
+    std::string_view const buffer = p.added ? std::string_view{m_added} : m_original;
+    return buffer.substr(p.start, p.length);
+}
+auto text_document::sub(piece const& p, std::size_t first, std::size_t count) -> piece {
+    return {.start = p.start + first, .length = std::uint32_t(count), .height = 0.0f, .added = p.added, .id = 0};
+}
+auto text_document::append(std::string_view a, std::string_view b) -> piece {
+    // Either part may point into the append buffer, which can move while growing.
+    m_scratch.assign(a);
+    m_scratch.append(b);
+    piece const p{.start = m_added.size(), .length = std::uint32_t(m_scratch.size()), .height = 0.0f, .added = true, .id = 0};
+    m_added.append(m_scratch);
+    return p;
+}
+auto text_document::assign(std::size_t index, piece const& p) -> void {
+    auto& line = m_lines[index];
+    if (line.added) m_added_live -= line.length;
+    if (p.added) m_added_live += p.length;
+    line    = p;
+    line.id = m_next_id++;
+}
+auto text_document::measure(std::size_t index, text_layout const& layout) -> void {
+    // Most lines are a single row as estimated, the sums after them stay valid.
+    auto& line = m_lines[index];
+    auto const estimate = line.height > 0.0f ? line.height : m_row_height;
+    line.height = layout.size().y;
+    if (line.height != estimate) invalidate_tops(index);
+}
+auto text_document::invalidate_tops(std::size_t index) -> void {
+    m_tops_dirty = std::min(m_tops_dirty, index + 1);
+}
+auto text_document::update_tops() -> void {
+    // Lines that weren't laid out move when the row height does, e.g. after the content scale changed.
+    if (auto const row = row_height(); row != m_row_height) {
+        m_row_height = row;
+        m_tops_dirty = 1;
+    }
+    m_tops.resize(m_lines.size() + 1);
+    for (auto i = m_tops_dirty; i < m_tops.size(); ++i) {
+        auto const height = m_lines[i - 1].height;
+        m_tops[i] = m_tops[i - 1] + (height > 0.0f ? height : m_row_height);
+    }
+    m_tops_dirty = m_tops.size();
+}
+auto text_document::compact() -> void {
+    if (m_added.size() < min_compact_bytes || m_added.size() < m_added_live * 2) return;
+    std::string added{};
+    added.reserve(m_added_live);
+    for (auto& line : m_lines) {
+        if (!line.added) continue;
+        auto const start = added.size();
+        added.append(view(line));
+        line.start = start;  // Same text, the id and cached layout stay
+    }
+    m_added = std::move(added);
+}
+} // namespace txt
@@ -0,0 +1,112 @@
+#ifndef TXT_TEXT_DOCUMENT_HPP
+#define TXT_TEXT_DOCUMENT_HPP
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utility.hpp"
+#include "fonts.hpp"
+#include "mapped_file.hpp"
+#include "text_layout.hpp"
+
+namespace txt {
+// Line and byte column within the line.
+struct text_position {
+    std::size_t line{0};
+    std::size_t column{0};
+};
+
+// Editable text for large documents, e.g. logs. A piece table with one piece per line: every line is a
+// span of either the original text, which is never copied, or the append-only buffer edits write to.
+// Splitting and joining lines only moves spans, text is copied when an edit concatenates within a line.
+// Lines end at '\n', which isn't part of them.
+//
+// Layouts are cached per line and keyed by the line's id, which changes whenever its text does. An edit
+// lays out only the lines it touched again, the rest reuse their glyph runs.
+//
+// Line heights are kept as prefix sums, so finding the line at a scroll offset is a binary search. Lines
+// count as one row until they're laid out, the sums are brought up to date from the first changed line
+// on the next lookup.
+class text_document {
+public:
+    text_document(std::string text = {}, std::size_t layout_capacity = 4096);
+    // The file stays mapped for as long as the document lives.
+    text_document(mapped_file_ref_t file, std::size_t layout_capacity = 4096);
+    ~text_document() = default;
+    text_document(text_document const&) = delete;
+    auto operator=(text_document const&) -> text_document& = delete;
+
+    auto line_count() const -> std::size_t { return m_lines.size(); }
+    auto line(std::size_t index) const -> std::string_view;
+    // Unique for as long as the line's text doesn't change.
+    auto line_id(std::size_t index) const -> std::uint64_t { return m_lines[index].id; }
+    auto text() const -> std::string;  // Lines joined by '\n'
+
+    // Returns the position right after the inserted text.
+    auto insert(text_position const& at, std::string_view str) -> text_position;
+    auto erase(text_position const& first, text_position const& last) -> void;
+
+    // Every line is laid out with this typeface and props, changing them drops the cached layouts.
+    auto set_layout(typeface_ref_t const& face, layout_props const& props = {}) -> void;
+    auto typeface() const -> typeface_ref_t const& { return m_typeface; }
+    // Laid out on first use and after the line changed. The reference is valid until the next call.
+    auto layout(std::size_t index) -> text_layout&;
+
+    // Offsets from the top of the document in layout units at scale 1, see text_layout::size().
+    auto row_height() -> float;  // Height of a line that wasn't laid out yet, advance_y of ' '
+    auto line_top(std::size_t index) -> float;  // line_count() gives the height of the document
+    // The line containing the offset, the first or last line for offsets outside the document.
+    auto line_at(float offset) -> std::size_t;
+
+private:
+    struct piece {
+        std::uint64_t start{0};
+        std::uint32_t length{0};
+        float         height{0.0f};  // Of the line's layout, 0 until it was laid out
+        bool          added{false};  // In the append buffer, the original text otherwise
+        std::uint64_t id{0};
+    };
+    struct cached_layout {
+        std::uint64_t id{0};
+        text_layout   layout{};
+    };
+    using layout_list = std::list<cached_layout>;
+
+private:
+    auto split_lines(std::string_view text) -> void;
+    auto view(piece const& p) const -> std::string_view;
+    auto sub(piece const& p, std::size_t first, std::size_t count) -> piece;
+    auto append(std::string_view a, std::string_view b) -> piece;
+    auto assign(std::size_t index, piece const& p) -> void;
+    auto compact() -> void;
+    auto measure(std::size_t index, text_layout const& layout) -> void;
+    auto invalidate_tops(std::size_t index) -> void;
+    auto update_tops() -> void;
+
+private:
+    std::string        m_original_text{};
+    mapped_file_ref_t  m_file{nullptr};
+    std::string_view   m_original{};
+    std::string        m_added{};
+    std::size_t        m_added_live{0};  // Bytes of the append buffer still referenced by a line
+    std::string        m_scratch{};
+    std::vector<piece> m_lines{};
+    std::uint64_t      m_next_id{1};
+
+    typeface_ref_t m_typeface{nullptr};
+    layout_props   m_props{};
+    std::size_t    m_layout_capacity;
+    layout_list    m_layouts{};  // Most recently used first
+    std::unordered_map<std::uint64_t, layout_list::iterator> m_layout_lookup{};
+
+    std::vector<float> m_tops{};        // Prefix sums of the line heights, line_count() + 1 entries
+    std::size_t        m_tops_dirty{1}; // First entry that may be stale
+    float              m_row_height{0.0f};
+};
+} // namespace txt
+
+#endif  // TXT_TEXT_DOCUMENT_HPP
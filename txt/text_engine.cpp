@@ -1,6 +1,11 @@
 #include "text_engine.hpp"
 #include "renderer.hpp"
-#include "utf8.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "glm/gtc/matrix_transform.hpp"
 
 namespace txt {
 static constexpr float quad_vertices[]{
@@ -15,22 +20,270 @@ static constexpr std::uint32_t quad_cw_indices[]{
     0, 2, 3
 };
 
-text_batch::text_batch(typeface_ref_t typeface) : m_typeface(typeface) {
+// Shader variants share one source, the mode is defined right after the #version line.
+// Values match the RENDER_MODE defines in text.frag.
+static constexpr std::int32_t shader_mode_subpixel = 1;
+static constexpr std::int32_t shader_mode_sdf      = 2;
+static constexpr std::int32_t shader_mode_msdf     = 3;
+
+// Pixel fonts and distance fields are rendered at a fixed size, only the others follow the content scale.
+static auto is_content_scaled(text_render_mode mode) -> bool {
+    return mode != text_render_mode::raster && !is_distance_field(mode);
+}
+
+// Fixed point units of text_batch::gpu, text.vert divides by the same. Quarter pixels reach 8192 pixels
+// either way, depth covers the renderer's range of 1024 and scales go up to 256.
+static constexpr float position_unit = 4.0f;
+static constexpr float depth_unit    = 64.0f;
+static constexpr float scale_unit    = 256.0f;
+// Glyph table rows hold this many glyphs, two texels each. Matches GLYPHS_PER_ROW in text.vert.
+static constexpr std::size_t glyph_table_width = 512;
+
+// Values out of range are clamped.
+template <typename T>
+static auto to_fixed(float value, float unit) -> T {
+    return T(std::clamp(std::round(value * unit), float(limits<T>::min()), float(limits<T>::max())));
+}
+
+// Layout of text_batch::gpu, one per instance. Integers are read as floats, the glyph index and depth
+// are exact.
+static auto instance_layout() -> attribute_descriptions_t {
+    return {
+        {type::i16vec2, false, 1},
+        {type::u16vec2, false, 1},
+        {type::u8vec4,  true,  1},
+        {type::u16vec2, false, 1},
+    };
+}
+
+// Layout of cell_grid::gpu, one per cell. The glyph index is exact as a float up to 2^24.
+static auto cell_layout() -> attribute_descriptions_t {
+    return {
+        {type::u32,    false, 1},
+        {type::u8vec4, true,  1},
+        {type::u8vec4, true,  1},
+    };
+}
+
+// Batches are copied over on reload, a counter shared by all of them keeps generations from repeating.
+static auto next_atlas_generation() -> std::uint64_t {
+    static std::uint64_t generation = 0;
+    return ++generation;
+}
+
+static auto with_render_mode(std::string const& src, std::int32_t mode) -> std::string {
+    auto const line_end = src.find('\n');
+    auto const at = line_end == std::string::npos ? src.size() : line_end + 1;
+    auto variant = src;
+    variant.insert(at, fmt::format("#define RENDER_MODE {}\n", mode));
+    return variant;
+}
+
+text_batch::text_batch(typeface_ref_t typeface, std::size_t padding)
+    : m_typeface(typeface)
+    , m_padding(padding) {
     generate_atlas();
 }
 
 auto text_batch::generate_atlas() -> void {
-    resize_atlas();
+    auto const& cache = m_typeface->cache();
+    if (cache != nullptr && cache->records().size() == m_typeface->glyphs().size() && cache->header().padding == m_padding) {
+        load_atlas(*cache);
+    } else {
+        std::vector<std::uint32_t> order(m_typeface->glyphs().size());
+        std::iota(std::begin(order), std::end(order), std::uint32_t(0));
+        pack_atlas(order);
+    }
+
     m_max_delta_origin_ymin = 0;
     m_max_bearing_left      = 0;
     m_max_bearing_top       = 0;
-    for (auto const& [code, glyph] : m_typeface->glyphs()) {
-        insert_bitmap(glyph);
-        m_max_delta_origin_ymin = std::max(std::int32_t(glyph.bitmap->height()) - glyph.bearing_top, m_max_delta_origin_ymin);
-        m_max_bearing_left = std::max(glyph.bearing_left, m_max_bearing_left);
-        m_max_bearing_top  = std::max(glyph.bearing_top, m_max_bearing_top);
+    for (auto const& glyph : m_typeface->glyphs())
+        update_metrics(glyph);
+    upload_atlas();
+
+    if (m_typeface->is_cache_stale())
+        m_typeface->store_cache(*m_atlas, pages(), m_uvs, m_padding);
+}
+auto text_batch::insert(std::uint32_t const& index) -> void {
+    if (m_atlas == nullptr || m_texture == nullptr) {
+        generate_atlas();
+        return;
+    }
+    if (!insert_bitmap(index)) {
+        if (pages() == 1 && m_page_size < max_page_size()) {
+            // Out of space, repack into a larger page with headroom so the next glyphs insert cheaply again.
+            m_min_size = std::min(m_page_size + m_page_size / 4, max_page_size());
+            generate_atlas();
+            return;
+        }
+        if (pages() < max_pages()) {
+            // Pages are full size, the glyphs placed so far stay where they are and only the new page is uploaded.
+            add_page();
+            insert_bitmap(index);
+            update_metrics(m_typeface->glyphs()[index]);
+            m_texture->add_layers(m_atlas->data(), pages());
+            return;
+        }
+        if (!evict_for(index)) {
+            compact(index);
+            return;
+        }
+    }
+
+    auto const& gh = m_typeface->glyphs()[index];
+    update_metrics(gh);
+    auto const uv   = m_uvs[index];
+    auto const slot = m_slots[index];
+    // With the padding, it was cleared along with the slot.
+    auto const padding = slot.x > 0 && slot.y > 0 ? m_padding : 0;
+    m_texture->sub(*m_atlas, std::size_t(uv.x), std::size_t(uv.y), std::size_t(uv.z), std::size_t(slot.x) + padding, std::size_t(slot.y) + padding);
+}
+auto text_batch::upload_table() -> void {
+    if (m_table_first >= m_table_last) return;
+    auto const rows = std::max((m_uvs.size() + glyph_table_width - 1) / glyph_table_width, std::size_t(1));
+    auto const row_texels = glyph_table_width * 2;
+    m_table_data.resize(rows * row_texels, glm::i16vec4{0});
+    auto const& metrics = m_typeface->metrics();
+    for (auto i = m_table_first; i < m_table_last; ++i) {
+        glm::ivec3 const uv{m_uvs[i]};
+        m_table_data[i * 2]     = {std::int16_t(uv.x), std::int16_t(uv.y), std::int16_t(uv.z), std::int16_t(0)};
+        m_table_data[i * 2 + 1] = {std::int16_t(metrics.width[i]), std::int16_t(metrics.height[i]), std::int16_t(metrics.bearing_left[i]), std::int16_t(metrics.bearing_top[i])};
+    }
+
+    if (m_table == nullptr || m_table->height() != rows) {
+        m_table = make_texture(m_table_data.data(), row_texels, rows, 4, {
+            .internal   = pixel_fmt::rgba_integer,
+            .format     = pixel_fmt::rgba_integer,
+            .min_filter = tex_filter::nearest,
+            .mag_filter = tex_filter::nearest,
+            .mipmap     = false,
+            .data_type  = type::i16,
+        });
+    } else {
+        auto const first_row = m_table_first / glyph_table_width;
+        auto const last_row  = (m_table_last - 1) / glyph_table_width + 1;
+        m_table->sub(m_table_data.data() + first_row * row_texels, 0, first_row, row_texels, last_row - first_row);
+    }
+    m_table_first = limits<std::size_t>::max();
+    m_table_last  = 0;
+}
+auto text_batch::invalidate_table(std::size_t first, std::size_t last) -> void {
+    m_table_first = std::min(m_table_first, first);
+    m_table_last  = std::max(m_table_last, last);
+}
+auto text_batch::rebuild() -> void {
+    m_min_size = 0;
+    generate_atlas();
+}
+auto text_batch::reset() -> void {
+    if (m_data.size() - m_size > 256) m_data.resize(m_size);
+    m_size = 0;
+    m_spans.clear();
+    ++m_frame;
+    // Released only now, an index pushed or shaped earlier in the frame must not change meaning under it.
+    // Glyphs drawn again after their eviction went back into the atlas and stay.
+    for (auto const& index : m_evicted) {
+        if (!contains(index)) m_typeface->evict(index);
+    }
+    m_evicted.clear();
+}
+auto text_batch::in_reach(glm::vec2 const& position) -> bool {
+    auto const reach = float(limits<std::int16_t>::max()) / position_unit;
+    return std::abs(position.x) <= reach && std::abs(position.y) <= reach;
+}
+auto text_batch::push(std::uint32_t const& index, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    glm::vec2 const pen{position};
+    if (m_spans.empty() || !in_reach(pen - m_spans.back().origin))
+        m_spans.push_back({glm::round(pen), m_size});
+    auto const new_char = instance(index, {pen - m_spans.back().origin, position.z}, color, scale);
+    if (m_size < m_data.size())
+        m_data[m_size] = new_char;
+    else
+        m_data.push_back(new_char);
+    ++m_size;
+    m_last_used[index] = m_frame;
+}
+auto text_batch::instance(std::uint32_t const& index, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale) const -> gpu {
+    if (index > limits<std::uint16_t>::max())
+        throw std::runtime_error(fmt::format("Glyph index {} doesn't fit the 16 bit instance format!", index));
+    return {
+        .position = {to_fixed<std::int16_t>(position.x, position_unit), to_fixed<std::int16_t>(position.y, position_unit)},
+        .glyph    = std::uint16_t(index),
+        .depth    = to_fixed<std::uint16_t>(position.z, depth_unit),
+        .color    = {
+            to_fixed<std::uint8_t>(color.x, 255.0f), to_fixed<std::uint8_t>(color.y, 255.0f),
+            to_fixed<std::uint8_t>(color.z, 255.0f), to_fixed<std::uint8_t>(color.w, 255.0f)
+        },
+        .scale    = {to_fixed<std::uint16_t>(scale.x, scale_unit), to_fixed<std::uint16_t>(scale.y, scale_unit)},
+    };
+}
+auto text_batch::touch(std::span<std::uint32_t const> indices) -> void {
+    for (auto const& index : indices) {
+        if (index < m_last_used.size()) m_last_used[index] = m_frame;
     }
+}
+
+auto text_batch::occupancy() const -> float {
+    if (m_page_size == 0) return 0.0f;
+    std::size_t used = 0;
+    for (auto const& packer : m_packers)
+        used += packer.used_area();
+    return float(double(used) / double(m_page_size * m_page_size * pages()));
+}
+
+auto text_batch::pack_atlas(std::vector<std::uint32_t> const& order) -> void {
+    auto const& metrics = m_typeface->metrics();
+    std::vector<glm::ivec2> sizes{};
+    sizes.reserve(order.size());
+    for (auto const& i : order)
+        sizes.push_back({std::int32_t(metrics.width[i]), std::int32_t(metrics.height[i])});
+    auto layout = layout_atlas(sizes, m_padding, m_min_size, max_page_size());
 
+    resize_atlas(layout.page_size);
+    while (pages() < layout.packers.size())
+        add_page();
+    m_packers = std::move(layout.packers);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        write_bitmap(order[i], layout.positions[i]);
+        m_slots[order[i]] = sizes[i];
+    }
+}
+auto text_batch::resize_atlas(std::size_t size) -> void {
+    if (m_atlas == nullptr || m_atlas->width() != size || m_atlas->height() != size || m_atlas->channels() != m_typeface->channels())
+        m_atlas = make_image_u8(nullptr, size, size, m_typeface->channels());
+    else
+        m_atlas->resize(size, size);  // Same size only clears the pixels
+    m_page_size = size;
+    m_packers.assign(1, skyline_packer{size, size, m_padding});
+    m_uvs.clear();
+    m_slots.clear();
+    m_generation = next_atlas_generation();
+}
+auto text_batch::add_page() -> void {
+    m_atlas->grow(m_atlas->height() + m_page_size);
+    m_packers.emplace_back(m_page_size, m_page_size, m_padding);
+}
+auto text_batch::load_atlas(glyph_cache const& cache) -> void {
+    auto const& header = cache.header();
+    m_atlas = make_image_u8(cache.atlas(), header.atlas_width, header.atlas_height, header.channels);
+    m_page_size = header.atlas_width;
+    m_packers.assign(header.pages, skyline_packer{header.atlas_width, header.atlas_height / header.pages, m_padding});
+    // Records are stored in glyph index order
+    m_uvs.clear();
+    m_uvs.reserve(cache.records().size());
+    m_slots.clear();
+    m_slots.reserve(cache.records().size());
+    for (auto const& record : cache.records()) {
+        m_uvs.push_back({record.uv_x, record.uv_y, float(record.page)});
+        m_slots.push_back({std::int32_t(record.width), std::int32_t(record.height)});
+        m_packers[record.page].occupy({std::int32_t(record.uv_x), std::int32_t(record.uv_y)}, record.width, record.height);
+    }
+    m_last_used.resize(std::max(m_last_used.size(), m_uvs.size()), 0);
+    m_generation = next_atlas_generation();
+    invalidate_table(0, m_uvs.size());
+}
+auto text_batch::upload_atlas() -> void {
     texture_props tex_props{};
     if (m_typeface->mode() == text_render_mode::raster) {
         tex_props.min_filter = tex_filter::nearest;
@@ -44,86 +297,116 @@ auto text_batch::generate_atlas() -> void {
     tex_props.mipmap = false;
 
     if (m_texture == nullptr)
-        m_texture = make_texture(m_atlas, tex_props);
+        m_texture = make_texture_array(*m_atlas, pages(), tex_props);
     else
-        m_texture->set(m_atlas, tex_props);
+        m_texture->set(*m_atlas, pages(), tex_props);
 }
-auto text_batch::reset() -> void {
-    if (m_data.size() - m_size > 256) m_data.resize(m_size);
-    m_size = 0;
+auto text_batch::max_page_size() const -> std::size_t {
+    auto const limit = std::min(atlas_page_size, max_texture_size());
+    auto const budget = m_typeface->atlas_budget();
+    if (budget == 0) return limit;
+    // Largest aligned square within the budget, never smaller than the largest glyph's slot so it fits.
+    auto const side = std::size_t(std::sqrt(double(budget) / double(m_typeface->channels())));
+    auto const slot = (m_typeface->glyph_size() + m_padding + 63) / 64 * 64;
+    return std::clamp(std::max(side / 64 * 64, slot), std::size_t(64), limit);
 }
-auto text_batch::push(glyph const& gh, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
-    auto const xpos = float(gh.bearing_left) + position.x;
-    auto const ypos = -(float(gh.bitmap->height()) - float(gh.bearing_top)) + position.y;
-    auto const w = float(gh.bitmap->width());
-    auto const h = float(gh.bitmap->height());
-    auto const uv = m_uv_map.at(gh.codepoint);
-
-    gpu const new_char{
-        .color     = color,
-        .position  = {xpos, ypos, position.z},
-        .scale     = {scale, 1.0f},
-        .uv_offset = glm::vec2{uv},
-        .uv_size   = {w, h}
-    };
-
-    if (m_size < m_data.size())
-        m_data[m_size] = new_char;
-    else
-        m_data.push_back(new_char);
-    ++m_size;
+auto text_batch::max_pages() const -> std::size_t {
+    auto const budget = m_typeface->atlas_budget();
+    if (budget == 0) return max_texture_layers();
+    auto const page_bytes = m_page_size * m_page_size * m_typeface->channels();
+    return std::clamp(budget / page_bytes, std::size_t(1), max_texture_layers());
 }
+auto text_batch::evict_for(std::uint32_t const& index) -> bool {
+    auto const& gh = m_typeface->glyphs()[index];
+    // Least recently drawn glyph whose slot is large enough, glyphs drawn this frame are in the instance data.
+    auto victim = glyph_table::npos;
+    for (auto i = m_typeface->pinned_glyphs(); i < m_uvs.size(); ++i) {
+        if (!contains(std::uint32_t(i)) || m_last_used[i] >= m_frame) continue;
+        if (std::size_t(m_slots[i].x) < gh.width || std::size_t(m_slots[i].y) < gh.height) continue;
+        if (victim == glyph_table::npos || m_last_used[i] < m_last_used[victim]) victim = std::uint32_t(i);
+    }
+    if (victim == glyph_table::npos) return false;
 
-auto text_batch::resize_atlas() -> void {
-    constexpr auto round_up2 = [](auto const& value) {
-        return std::pow(2, std::ceil(std::log2(value) / std::log2(2)));
-    };
-    auto const cols = static_cast<std::size_t>(std::ceil(std::sqrt(m_typeface->glyphs().size())));
-    auto const msp2 = static_cast<std::size_t>(round_up2(m_typeface->glyph_size()));  // Glyph max size round to power of 2
-    auto const size = static_cast<std::size_t>(round_up2(cols * msp2));
-    if (m_atlas == nullptr || m_atlas->width() != size) {
-        m_atlas = make_image_u8(nullptr, size, size, m_typeface->channels());
-        m_current_uv = {0, std::int32_t(size) - 1};
+    // The slot keeps its size, a smaller glyph leaves the rest of it empty until the slot is reused again.
+    glm::ivec3 const position{m_uvs[victim]};
+    auto const slot = m_slots[victim];
+    m_uvs[victim] = no_uv;
+    m_evicted.push_back(victim);
+    m_generation = next_atlas_generation();
+    auto const row = std::size_t(position.z) * m_page_size + std::size_t(position.y);
+    if (slot.x > 0 && slot.y > 0)
+        m_atlas->clear(std::size_t(position.x), row, std::size_t(slot.x) + m_padding, std::size_t(slot.y) + m_padding);
+    write_bitmap(index, position);
+    m_slots[index] = slot;
+    return true;
+}
+auto text_batch::compact(std::uint32_t const& index) -> void {
+    // No single cold slot fits, repack what is pinned or drawn this frame and evict everything else.
+    // The atlas only grows past the budget when that alone doesn't fit.
+    std::vector<std::uint32_t> order{};
+    for (std::uint32_t i = 0; i < m_uvs.size(); ++i) {
+        if (!contains(i)) continue;
+        if (i < m_typeface->pinned_glyphs() || m_last_used[i] >= m_frame)
+            order.push_back(i);
+        else
+            m_evicted.push_back(i);
     }
+    order.push_back(index);
+    m_min_size = m_page_size;
+    pack_atlas(order);
+    update_metrics(m_typeface->glyphs()[index]);
+    upload_atlas();
 }
-auto text_batch::insert_bitmap(txt::glyph const& glyph) -> void {
-    auto const& bm = glyph.bitmap;
-    for (std::size_t i = 0; i < bm->height(); ++i) {
-        for (std::size_t j = 0; j < bm->width(); ++j) {
-            auto const pixel = bm->pixel(j, i);
-            m_atlas->set(std::size_t(m_current_uv.x) + j, std::size_t(m_current_uv.y) - i, pixel);
-        }
+auto text_batch::insert_bitmap(std::uint32_t const& index) -> bool {
+    auto const& gh = m_typeface->glyphs()[index];
+    for (std::size_t page = 0; page < m_packers.size(); ++page) {
+        auto const position = m_packers[page].pack(gh.width, gh.height);
+        if (!position.has_value()) continue;
+        write_bitmap(index, {*position, std::int32_t(page)});
+        m_slots[index] = {std::int32_t(gh.width), std::int32_t(gh.height)};
+        return true;
     }
-
-    m_uv_map.insert_or_assign(glyph.codepoint,
-        glm::vec2{
-            float(m_current_uv.x),
-            float(m_current_uv.y - std::int32_t(bm->height() - 1))
-        }
-    );
-
-    auto const glyph_size = m_typeface->glyph_size();
-    m_current_uv.x += std::int32_t(glyph_size);
-    if (m_current_uv.x >= std::int32_t(m_atlas->width() - glyph_size)) {
-        m_current_uv.x = 0;
-        m_current_uv.y -= std::int32_t(glyph_size);
+    return false;
+}
+auto text_batch::write_bitmap(std::uint32_t const& index, glm::ivec3 const& position) -> void {
+    // Bitmap rows are top-down, atlas rows follow the texture and go bottom-up.
+    auto const& gh    = m_typeface->glyphs()[index];
+    auto const x      = std::size_t(position.x);
+    auto const y      = std::size_t(position.z) * m_page_size + std::size_t(position.y);
+    auto const pitch  = std::size_t(gh.width) * m_atlas->channels();
+    auto const* bytes = m_typeface->bitmap(gh);
+    // The area may have held another glyph, e.g. one rendered from a fallback. Left over texels in the
+    // padding would bleed into this one under bilinear and distance field sampling. Empty glyphs don't
+    // reserve any area.
+    if (gh.width > 0 && gh.height > 0) m_atlas->clear(x, y, gh.width + m_padding, gh.height + m_padding);
+    for (std::size_t i = 0; i < gh.height; ++i)
+        m_atlas->set_row(x, y + gh.height - 1 - i, bytes + i * pitch, gh.width);
+    if (m_uvs.size() <= index) {
+        m_uvs.resize(index + 1, no_uv);
+        m_slots.resize(index + 1, glm::ivec2{0});
     }
+    if (m_last_used.size() <= index) m_last_used.resize(index + 1, 0);
+    m_uvs[index] = glm::vec3{position};
+    invalidate_table(index, index + 1);
+}
+auto text_batch::update_metrics(txt::glyph const& glyph) -> void {
+    m_max_delta_origin_ymin = std::max(std::int32_t(glyph.height) - glyph.bearing_top, m_max_delta_origin_ymin);
+    m_max_bearing_left = std::max(glyph.bearing_left, m_max_bearing_left);
+    m_max_bearing_top  = std::max(glyph.bearing_top, m_max_bearing_top);
 }
 
-text_engine::text_engine(window_ref_t window, font_manager_ref_t manager) : m_window(window), m_manager(manager) {
+text_engine::text_engine(window_ref_t window, font_manager_ref_t manager)
+    : m_window(window)
+    , m_manager(manager)
+    , m_content_scale(window->content_scale_x()) {
     m_index_buffer = make_index_buffer(quad_cw_indices, sizeof(quad_cw_indices), len(quad_cw_indices), type::u32, usage::static_draw);
-    m_instance_buffer = make_vertex_buffer(nullptr, sizeof(text_batch::gpu), type::f32, usage::dynamic_draw, {
-        {type::vec4, false, 1},
-        {type::vec3, false, 1},
-        {type::vec3, false, 1},
-        {type::vec2, false, 1},
-        {type::vec2, false, 1},
-    });
-    m_descriptor = make_attribute_descriptor();
-    m_descriptor->add(make_vertex_buffer(quad_vertices, sizeof(quad_vertices), type::f32, usage::static_draw, {
+    m_instance_buffer = make_vertex_buffer(nullptr, sizeof(text_batch::gpu), type::f32, usage::dynamic_draw, instance_layout());
+    m_quad_buffer = make_vertex_buffer(quad_vertices, sizeof(quad_vertices), type::f32, usage::static_draw, {
         {type::vec3, false, 0},
         {type::vec2, false, 0},
-    }));
+    });
+    m_descriptor = make_attribute_descriptor();
+    m_descriptor->add(m_quad_buffer);
     m_descriptor->add(m_instance_buffer);
 
     m_manager->load({
@@ -144,19 +427,42 @@ text_engine::text_engine(window_ref_t window, font_manager_ref_t manager) : m_wi
     auto vs = read_text("./shaders/webgl/text.vert");
     auto fs = read_text("./shaders/webgl/text.frag");
 #endif
-    m_shader_normal = make_shader(vs, fs);
+    m_shader_normal   = make_shader(vs, fs);
+    m_shader_subpixel = make_shader(vs, with_render_mode(fs, shader_mode_subpixel));
+    m_shader_sdf      = make_shader(vs, with_render_mode(fs, shader_mode_sdf));
+    m_shader_msdf     = make_shader(vs, with_render_mode(fs, shader_mode_msdf));
+
+#ifndef __EMSCRIPTEN__
+    auto grid_vs = read_text("./shaders/opengl/grid.vert");
+    auto grid_fs = read_text("./shaders/opengl/grid.frag");
+#else
+    auto grid_vs = read_text("./shaders/webgl/grid.vert");
+    auto grid_fs = read_text("./shaders/webgl/grid.frag");
+#endif
+    m_grid_normal   = make_shader(grid_vs, grid_fs);
+    m_grid_subpixel = make_shader(grid_vs, with_render_mode(grid_fs, shader_mode_subpixel));
+    m_grid_sdf      = make_shader(grid_vs, with_render_mode(grid_fs, shader_mode_sdf));
+    m_grid_msdf     = make_shader(grid_vs, with_render_mode(grid_fs, shader_mode_msdf));
 }
 auto text_engine::load(typeface_props const props) -> void {
     m_manager->load({
-        .filename = props.filename,
-        .size     = props.size,
+        .filename   = props.filename,
+        .face_index = props.face_index,
+        .size       = props.size,
         .family   = props.family,
         .style    = props.style,
         .render_mode = props.render_mode,
         .ranges      = props.ranges,
-        .scale       = props.render_mode == text_render_mode::raster ? 1.0 : m_window->content_scale_x()
+        .scale       = is_content_scaled(props.render_mode) ? m_content_scale : 1.0,
+        .threads     = props.threads,
+        .cache        = props.cache,
+        .atlas_budget = props.atlas_budget
     });
 }
+auto text_engine::load_async(typeface_props props) -> font_handle_ref_t {
+    props.scale = is_content_scaled(props.render_mode) ? m_content_scale : 1.0;
+    return m_manager->load_async(props);
+}
 
 auto text_engine::typeface(std::string const& family, std::string const& style) -> typeface_ref_t {
     auto const it = m_manager->families().find(family);
@@ -164,68 +470,117 @@ auto text_engine::typeface(std::string const& family, std::string const& style)
     return it->second->typeface(style);
 }
 
-auto text_engine::text(std::string const& str, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& typeface) -> void {
+auto text_engine::text(std::string_view str, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale, typeface_ref_t const& typeface) -> void {
     typeface_ref_t current = typeface == nullptr ? m_typeface : typeface;
     auto it = m_batches.find(current);
     if (it == std::end(m_batches)) reload();
     it = m_batches.find(current);
     auto& batch = it->second;
 
-    std::u32string tmp_str{};
-    utf8::utf8to32(std::begin(str), std::end(str), std::back_inserter(tmp_str));
-    glm::vec2 pos = position;
     // std::int64_t advance_y = 0;
-    auto font_scale = 1.0f;
-    if (current->mode() != text_render_mode::raster) {
-        font_scale *= 1.0f / float(m_window->content_scale_x());
+    auto const font_scale = current->layout_scale();
+    auto const pen_scale  = scale.x * font_scale / 64.0f;  // Run offsets are 26.6
+    auto const y = position.y + float(batch.max_delta_origin_ymin()) * scale.y * font_scale;
+
+    auto const& run = m_runs.get(current, str);
+    for (std::size_t i = 0; i < run.size(); ++i) {
+        auto const index = run.indices[i];
+        if (!batch.contains(index)) batch.insert(index);
+        batch.push(index, {position.x + float(run.offsets[i]) * pen_scale, y, position.z}, color, scale * font_scale);
     }
+}
+auto text_engine::layout(text_layout& layout, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    return layout.update(typeface == nullptr ? m_typeface : typeface, str, props);
+}
+auto text_engine::text(text_layout& layout, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    layout.refresh();
+    auto const& current = layout.typeface();
+    if (current == nullptr) return;
+    auto it = m_batches.find(current);
+    if (it == std::end(m_batches)) reload();
+    it = m_batches.find(current);
+    auto& batch = it->second;
 
-    for (auto const& code : tmp_str) {
-        auto const size = current->glyph_size();
-        auto const& gh = current->query(code);
-        if (size != current->glyph_size()) batch.generate_atlas();
+    auto const font_scale = current->layout_scale();
+    auto const y = position.y + float(batch.max_delta_origin_ymin()) * scale.y * font_scale;
+    auto const& indices   = layout.indices();
+    auto const& positions = layout.positions();
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        auto const index = indices[i];
+        if (!batch.contains(index)) batch.insert(index);
+        batch.push(index, {position.x + positions[i].x * scale.x, y + positions[i].y * scale.y, position.z}, color, scale * font_scale);
+    }
+}
+auto text_engine::text(text_document& document, std::size_t first, std::size_t count, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    auto const last = std::min(first + count, document.line_count());
+    auto y = position.y;
+    for (auto i = first; i < last; ++i) {
+        auto& layout = document.layout(i);
+        text(layout, {position.x, y, position.z}, color, scale);
+        y -= layout.size().y * scale.y;
+    }
+}
+auto text_engine::text(text_document& document, float scroll, glm::vec3 const& position, glm::vec4 const& color, glm::vec2 const& scale) -> void {
+    // A line's first row is above its position, so offsets are shifted by a row: a line is visible while
+    // its bottom is below the window's top edge and its top above the bottom edge.
+    auto const origin = position.y + scroll;
+    auto const row    = document.row_height();
+    auto const from   = (origin - float(m_window->height())) / scale.y + row;
+    auto const to     = origin / scale.y + row;
 
-        batch.push(gh, {pos.x, pos.y + float(batch.max_delta_origin_ymin()), position.z}, color, scale * font_scale);
-        pos.x += float(gh.advance_x >> 6) * scale.x * font_scale;
+    auto const first = document.line_at(from);
+    auto offset = document.line_top(first);
+    for (auto i = first; i < document.line_count() && offset < to; ++i) {
+        auto& layout = document.layout(i);
+        text(layout, {position.x, origin - offset * scale.y, position.z}, color, scale);
+        offset += layout.size().y;
     }
 }
-auto text_engine::text_size(std::string const& str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
+auto text_engine::layout(text_object& object, std::string_view str, layout_props const& props, typeface_ref_t const& typeface) -> bool {
+    auto const changed = object.m_layout.update(typeface == nullptr ? m_typeface : typeface, str, props);
+    object.m_dirty = object.m_dirty || changed;
+    return changed;
+}
+auto text_engine::text(text_object& object, float depth) -> void {
+    m_objects.emplace_back(&object, depth);
+}
+auto text_engine::text(cell_grid& grid, glm::vec3 const& position, glm::vec2 const& scale) -> void {
+    m_grids.push_back({&grid, position, scale});
+}
+auto text_engine::text_size(std::string_view str, glm::vec2 const& scale, typeface_ref_t const& typeface) -> glm::vec2 {
     typeface_ref_t current = typeface == nullptr ? m_typeface : typeface;
     auto it = m_batches.find(current);
     if (it == std::end(m_batches)) reload();
     it = m_batches.find(current);
     auto& batch = it->second;
 
-    std::u32string tmp_str{};
-    utf8::utf8to32(std::begin(str), std::end(str), std::back_inserter(tmp_str));
     glm::vec2 pos{0.0f};
     // std::int64_t advance_y = 0;
-    auto font_scale = 1.0f;
-    if (current->mode() != text_render_mode::raster) {
-        font_scale *= 1.0f / float(m_window->content_scale_x());
-    }
+    auto const font_scale = current->layout_scale();
+    auto const pen_scale  = scale.x * font_scale / 64.0f;
 
     glm::vec2 min_position{limits<float>::max()};
     glm::vec2 max_position{limits<float>::min()};
-    for (auto const& code : tmp_str) {
-        auto const size = current->glyph_size();
-        auto const& gh = current->query(code);
-        if (size != current->glyph_size()) batch.generate_atlas();
+    auto const& run = m_runs.get(current, str);
+    auto const& metrics = current->metrics();
+    for (std::size_t i = 0; i < run.size(); ++i) {
+        auto const index = run.indices[i];
+        if (!batch.contains(index)) batch.insert(index);
 
+        pos.x = float(run.offsets[i]) * pen_scale;
         glm::vec2 const bl{
             pos.x,
             pos.y - float(batch.max_delta_origin_ymin()) * scale.y * font_scale
         };
         glm::vec2 const tr{
-            pos.x + float(batch.max_bearing_left() + std::int32_t(gh.bitmap->width())) * scale.x * font_scale,
+            pos.x + float(batch.max_bearing_left() + metrics.width[index]) * scale.x * font_scale,
             // pos.y + float(batch.max_bearing_top()) * scale.y * font_scale
-            pos.y + float(gh.bitmap->height()) * scale.y * font_scale
+            pos.y + float(metrics.height[index]) * scale.y * font_scale
         };
         min_position.x = std::min(bl.x, min_position.x);
         min_position.y = std::min(bl.y, min_position.y);
         max_position.x = std::max(tr.x, max_position.x);
         max_position.y = std::max(tr.y, max_position.y);
-        pos.x += float(gh.advance_x >> 6) * scale.x * font_scale;
     }
 
     return max_position - min_position;
@@ -242,38 +597,215 @@ auto text_engine::reload() -> void {
 auto text_engine::begin() -> void {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    for (auto& [tf, batch] : m_batches)
+    // Fonts loaded in the background get their atlas here, a scale change since they started is rendered
+    // like any other.
+    for (auto const& tf : m_manager->adopt_loaded()) {
+        m_batches.insert_or_assign(tf, text_batch{tf});
+        if (is_content_scaled(tf->mode()) && tf->scale() != m_content_scale) tf->rescale(m_content_scale);
+    }
+    if (auto const scale = m_window->content_scale_x(); scale != m_content_scale) {
+        m_content_scale = scale;
+        for (auto& [tf, batch] : m_batches) {
+            if (is_content_scaled(tf->mode())) tf->rescale(scale);
+        }
+    }
+    for (auto& [tf, batch] : m_batches) {
         batch.reset();
+        if (tf->finish_rescale()) batch.rebuild();
+    }
 }
 auto text_engine::end() -> void {
-    for (auto const& [tf, batch] : m_batches) {
+    // Objects insert their missing glyphs first, a repack for them also moves what was pushed this frame.
+    for (auto const& [object, depth] : m_objects)
+        write_instances(*object);
+    for (auto const& queued : m_grids)
+        write_cells(*queued.grid);
+    for (auto& [tf, batch] : m_batches)
+        batch.upload_table();
+
+    // Grids are opaque, text drawn this frame goes on top of them.
+    for (auto const& queued : m_grids)
+        render_grid(*queued.grid, queued.position, queued.scale);
+    m_grids.clear();
+
+    m_tint = glm::vec4{1.0f};
+    for (auto& [tf, batch] : m_batches) {
         if (batch.size() == 0) continue;
-        m_instance_buffer->bind();
-        m_instance_buffer->resize(batch.size() * sizeof(text_batch::gpu));
-        m_instance_buffer->sub(batch.chars().data(), batch.size() * sizeof(text_batch::gpu));
-        m_instance_buffer->unbind();
+        // Usually one span, text spread further than the fixed point reaches is drawn a span at a time.
+        auto const& spans = batch.spans();
+        for (std::size_t i = 0; i < spans.size(); ++i) {
+            auto const first = spans[i].first;
+            auto const count = (i + 1 < spans.size() ? spans[i + 1].first : batch.size()) - first;
+            m_instance_buffer->bind();
+            if (i == 0) m_instance_buffer->resize(batch.size() * sizeof(text_batch::gpu));
+            m_instance_buffer->sub(batch.chars().data() + first, count * sizeof(text_batch::gpu));
+            m_instance_buffer->unbind();
+            m_model = glm::translate(glm::mat4{1.0f}, {spans[i].origin, 0.0f});
+            render(tf->mode(), batch, *m_descriptor, count);
+        }
+    }
 
-        if (tf->mode() == text_render_mode::subpixel)
-            render_subpixel(batch);
-        else
-            render_normal(batch);
+    for (auto const& [object, depth] : m_objects)
+        render_object(*object, depth);
+    m_objects.clear();
+}
+
+auto text_engine::write_instances(text_object& object) -> void {
+    auto& layout = object.m_layout;
+    if (layout.refresh()) object.m_dirty = true;
+    auto const& current = layout.typeface();
+    if (current == nullptr) return;
+    auto it = m_batches.find(current);
+    if (it == std::end(m_batches)) reload();
+    it = m_batches.find(current);
+    auto& batch = it->second;
+
+    // Glyphs of the object stay in the atlas this frame, inserting the missing ones doesn't evict them.
+    auto const& indices = layout.indices();
+    batch.touch(indices);
+    for (auto const& index : indices) {
+        if (!batch.contains(index)) batch.insert(index);
+    }
+    if (!object.m_dirty && object.m_atlas == batch.generation()) return;
+
+    // Written at scale 1 from the layout's origin, the object's transform and baseline go in u_model.
+    // Glyphs further from it than the fixed point reaches are left out.
+    auto const font_scale = current->layout_scale();
+    auto const& positions = layout.positions();
+    m_object_data.clear();
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        if (text_batch::in_reach(positions[i]))
+            m_object_data.push_back(batch.instance(indices[i], {positions[i], 0.0f}, glm::vec4{1.0f}, glm::vec2{font_scale}));
+    }
+
+    object.m_instances = m_object_data.size();
+    object.m_atlas     = batch.generation();
+    object.m_dirty     = false;
+    if (object.m_instances == 0) return;
+    auto const bytes = object.m_instances * sizeof(text_batch::gpu);
+    if (object.m_descriptor == nullptr) {
+        object.m_buffer = make_vertex_buffer(nullptr, bytes, type::f32, usage::static_draw, instance_layout());
+        object.m_descriptor = make_attribute_descriptor();
+        object.m_descriptor->add(m_quad_buffer);
+        object.m_descriptor->add(object.m_buffer);
+    }
+    object.m_buffer->bind();
+    if (bytes > object.m_buffer->bytes()) object.m_buffer->resize(bytes);
+    object.m_buffer->sub(m_object_data.data(), bytes);
+    object.m_buffer->unbind();
+}
+auto text_engine::render_object(text_object const& object, float depth) -> void {
+    if (object.m_instances == 0) return;
+    auto const& current = object.m_layout.typeface();
+    auto const& batch   = m_batches.find(current)->second;
+    auto const baseline = float(batch.max_delta_origin_ymin()) * object.m_scale.y * current->layout_scale();
+    m_model = glm::translate(glm::mat4{1.0f}, {object.m_position.x, object.m_position.y + baseline, depth});
+    m_model = glm::scale(m_model, {object.m_scale, 1.0f});
+    m_tint  = object.m_color;
+    render(current->mode(), batch, *object.m_descriptor, object.m_instances);
+}
+
+auto text_engine::write_cells(cell_grid& grid) -> void {
+    grid.refresh();
+    auto const& current = grid.typeface();
+    auto it = m_batches.find(current);
+    if (it == std::end(m_batches)) reload();
+    it = m_batches.find(current);
+    auto& batch = it->second;
+
+    // Cells hold glyph indices, the table tells the shader where they are in the atlas. Glyphs moving
+    // there don't touch the cells.
+    batch.touch(grid.m_glyphs);
+    for (auto const& index : grid.m_glyphs) {
+        if (!batch.contains(index)) batch.insert(index);
+    }
+
+    if (grid.m_descriptor == nullptr) {
+        grid.m_buffer = make_vertex_buffer(grid.m_cells.data(), grid.m_cells.size() * sizeof(cell_grid::gpu), type::f32, usage::dynamic_draw, cell_layout());
+        grid.m_descriptor = make_attribute_descriptor();
+        grid.m_descriptor->add(m_quad_buffer);
+        grid.m_descriptor->add(grid.m_buffer);
     }
+    grid.take_dirty(m_cell_ranges);
+    if (m_cell_ranges.empty()) return;
+    grid.m_buffer->bind();
+    for (auto const& [first, last] : m_cell_ranges)
+        grid.m_buffer->sub(grid.m_cells.data() + first, (last - first) * sizeof(cell_grid::gpu), first * sizeof(cell_grid::gpu));
+    grid.m_buffer->unbind();
 }
+auto text_engine::render_grid(cell_grid const& grid, glm::vec3 const& position, glm::vec2 const& scale) -> void {
+    auto const& current = grid.typeface();
+    auto const& batch   = m_batches.find(current)->second;
+    auto const mode = current->mode();
+    auto const& shader = mode == text_render_mode::subpixel ? m_grid_subpixel
+                       : mode == text_render_mode::sdf      ? m_grid_sdf
+                       : mode == text_render_mode::msdf     ? m_grid_msdf
+                       : m_grid_normal;
+    auto const font_scale = current->layout_scale();
 
-auto text_engine::render_normal(text_batch const& batch) -> void {
-    m_shader_normal->bind();
-    m_model = glm::mat4{1.0f};
-    m_shader_normal->upload_mat4("u_model", m_model);
-    m_shader_normal->upload_mat4("u_view", m_view);
-    m_shader_normal->upload_mat4("u_projection", m_projection);
-    m_shader_normal->upload_vec2("u_size", {float(batch.texture()->width()), float(batch.texture()->height())});
-    m_shader_normal->upload_num("u_texture", 0);
+    shader->bind();
+    shader->upload_mat4("u_view", m_view);
+    shader->upload_mat4("u_projection", m_projection);
+    shader->upload_vec3("u_origin", position);
+    // Cells are sized in atlas pixels, u_scale takes them to the screen like the glyphs.
+    shader->upload_vec2("u_cell", grid.cell_size() / font_scale);
+    shader->upload_vec2("u_scale", scale * font_scale);
+    shader->upload_num("u_descent", float(batch.max_delta_origin_ymin()));
+    shader->upload_num("u_rows", std::int32_t(grid.m_rows));
+    shader->upload_num("u_cols", std::int32_t(grid.m_cols));
+    shader->upload_num("u_first_row", std::int32_t(grid.m_first_row));
+    shader->upload_vec2("u_size", {float(batch.texture()->width()), float(batch.texture()->height())});
+    shader->upload_num("u_texture", 0);
+    shader->upload_num("u_glyphs", 1);
     batch.texture()->bind(0);
-    m_descriptor->bind();
+    batch.table()->bind(1);
+    grid.m_descriptor->bind();
     m_index_buffer->bind();
-    glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_index_buffer->size()), gl_type(m_index_buffer->type()), nullptr, GLsizei(batch.size()));
+    glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_index_buffer->size()), gl_type(m_index_buffer->type()), nullptr, GLsizei(grid.m_cells.size()));
+}
+
+auto text_engine::render(text_render_mode mode, text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void {
+    if (mode == text_render_mode::subpixel)
+        render_subpixel(batch, descriptor, instances);
+    else if (mode == text_render_mode::sdf)
+        render_sdf(batch, descriptor, instances);
+    else if (mode == text_render_mode::msdf)
+        render_msdf(batch, descriptor, instances);
+    else
+        render_normal(batch, descriptor, instances);
+}
+auto text_engine::render_normal(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void {
+    render_batch(batch, m_shader_normal, descriptor, instances);
 }
-auto text_engine::render_subpixel(text_batch const& batch) -> void {
-    (void)batch;
+auto text_engine::render_sdf(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void {
+    render_batch(batch, m_shader_sdf, descriptor, instances);
+}
+auto text_engine::render_msdf(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void {
+    render_batch(batch, m_shader_msdf, descriptor, instances);
+}
+auto text_engine::render_subpixel(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void {
+#ifndef __EMSCRIPTEN__
+    // Second fragment output carries per channel coverage, blend each subpixel on its own.
+    glBlendFunc(GL_SRC1_COLOR, GL_ONE_MINUS_SRC1_COLOR);
+    render_batch(batch, m_shader_subpixel, descriptor, instances);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+#else
+    render_batch(batch, m_shader_subpixel, descriptor, instances);
+#endif
+}
+auto text_engine::render_batch(text_batch const& batch, shader_ref_t const& shader, attribute_descriptor const& descriptor, std::size_t instances) -> void {
+    shader->bind();
+    shader->upload_mat4("u_model", m_model);
+    shader->upload_vec4("u_color", m_tint);
+    shader->upload_mat4("u_view", m_view);
+    shader->upload_mat4("u_projection", m_projection);
+    shader->upload_vec2("u_size", {float(batch.texture()->width()), float(batch.texture()->height())});
+    shader->upload_num("u_texture", 0);
+    shader->upload_num("u_glyphs", 1);
+    batch.texture()->bind(0);
+    batch.table()->bind(1);
+    descriptor.bind();
+    m_index_buffer->bind();
+    glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_index_buffer->size()), gl_type(m_index_buffer->type()), nullptr, GLsizei(instances));
 }
 } // namespace txt
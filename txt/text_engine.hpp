@@ -2,6 +2,7 @@
 #define TXT_TEXT_ENGINE_HPP
 
 #include <map>
+#include <span>
 
 #include "utility.hpp"
 #include "window.hpp"
@@ -10,48 +11,117 @@
 #include "shader.hpp"
 #include "texture.hpp"
 #include "buffer.hpp"
+#include "packer.hpp"
+#include "shaping.hpp"
+#include "text_layout.hpp"
+#include "text_document.hpp"
+#include "text_object.hpp"
+#include "cell_grid.hpp"
 
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
+#include "glm/gtc/type_precision.hpp"
 
 namespace txt {
 class text_batch {
 public:
+    static inline glm::vec3 const no_uv{-1.0f, -1.0f, -1.0f};  // Glyph index not placed in the atlas yet
+
+    // 16 bytes of fixed point. The glyph's size, bearings and place in the atlas are looked up in the glyph
+    // table, the vertex shader places the quad from the pen position.
     struct gpu {
-        glm::vec4 color;
-        glm::vec3 position;
-        glm::vec3 scale;
-        glm::vec2 uv_offset;
-        glm::vec2 uv_size;
+        glm::i16vec2  position;  // Pen position in quarter pixels
+        std::uint16_t glyph;     // Glyph index, the entry of the glyph table
+        std::uint16_t depth;     // 1/64
+        glm::u8vec4   color;
+        glm::u16vec2  scale;     // 8.8
+    };
+    static_assert(sizeof(gpu) == 16);
+    // Instances [first, next span's first) hold positions relative to origin, drawn with it in u_model.
+    // push() starts a new span when a position is out of the fixed point's reach from the current one.
+    struct span {
+        glm::vec2   origin;
+        std::size_t first;
     };
+    // Whether an instance position fits the fixed point format, see instance().
+    static auto in_reach(glm::vec2 const& position) -> bool;
 
 public:
-    text_batch(typeface_ref_t typeface);
+    text_batch(typeface_ref_t typeface, std::size_t padding = atlas_padding);
     ~text_batch() = default;
 
     auto size() const -> std::size_t { return m_size; }
     auto chars() const -> std::vector<gpu> const& { return m_data; }
-    auto texture() const -> texture_ref_t const& { return m_texture; }
+    auto spans() const -> std::vector<span> const& { return m_spans; }
+    auto texture() const -> texture_array_ref_t const& { return m_texture; }
+    // Atlas position and page, then size and bearings of every glyph index. Two texels per glyph, uploaded
+    // by upload_table() when glyphs were placed.
+    auto table() const -> texture_ref_t const& { return m_table; }
+    // Atlas pages stacked bottom to top, page_size() rows each.
     auto bitmap() const -> image_u8_ref_t const& { return m_atlas; }
+    auto pages() const -> std::size_t { return m_packers.size(); }
+    auto page_size() const -> std::size_t { return m_page_size; }
     auto max_delta_origin_ymin() const -> std::int32_t { return m_max_delta_origin_ymin; }
     auto max_bearing_left() const -> std::int32_t { return m_max_bearing_left; }
     auto max_bearing_top() const -> std::int32_t { return m_max_bearing_top; }
+    // Glyph indices are the typeface's dense indices, see typeface::index.
+    auto contains(std::uint32_t const& index) const -> bool { return index < m_uvs.size() && m_uvs[index].x >= 0.0f; }
+    auto occupancy() const -> float;
+    // Changes whenever glyphs already in the atlas move or leave it, unique across batches.
+    auto generation() const -> std::uint64_t { return m_generation; }
     auto generate_atlas() -> void;
+    // Every glyph was rendered again, e.g. for a new content scale. Packed from scratch without headroom.
+    auto rebuild() -> void;
+    // Place a glyph loaded after the atlas was generated and upload only its region. A full atlas gets
+    // another page, once it is at the typeface's budget the least recently drawn glyph with a large
+    // enough slot makes room for it.
+    auto insert(std::uint32_t const& index) -> void;
+    // Starts a new frame. Glyphs evicted during the last one are released from the typeface.
     auto reset() -> void;
-    auto push(glyph const& code, glm::vec3 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+    auto push(std::uint32_t const& index, glm::vec3 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+    // Instance data of a glyph in the atlas. Positions out of reach are clamped, push() re-bases them.
+    auto instance(std::uint32_t const& index, glm::vec3 const& position, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) const -> gpu;
+    // Glyphs drawn this frame without being pushed, they aren't evicted for others until the next one.
+    auto touch(std::span<std::uint32_t const> indices) -> void;
+    // Upload the glyph table entries that changed since the last call, before drawing.
+    auto upload_table() -> void;
 
 private:
-    auto resize_atlas() -> void;
-    auto insert_bitmap(txt::glyph const& glyph) -> void;
+    auto pack_atlas(std::vector<std::uint32_t> const& order) -> void;
+    auto resize_atlas(std::size_t size) -> void;
+    auto add_page() -> void;
+    auto load_atlas(glyph_cache const& cache) -> void;
+    auto upload_atlas() -> void;
+    auto max_page_size() const -> std::size_t;
+    auto max_pages() const -> std::size_t;
+    auto evict_for(std::uint32_t const& index) -> bool;
+    auto compact(std::uint32_t const& index) -> void;
+    auto insert_bitmap(std::uint32_t const& index) -> bool;
+    auto write_bitmap(std::uint32_t const& index, glm::ivec3 const& position) -> void;
+    auto update_metrics(txt::glyph const& glyph) -> void;
+    auto invalidate_table(std::size_t first, std::size_t last) -> void;
 
 private:
     typeface_ref_t   m_typeface;
     std::vector<gpu> m_data{};
     std::size_t      m_size{0};
+    std::vector<span> m_spans{};  // Of this frame's instances
     image_u8_ref_t   m_atlas{nullptr};
-    std::map<std::uint32_t, glm::vec2> m_uv_map{};
-    glm::ivec2    m_current_uv{0, 0};
-    texture_ref_t m_texture{nullptr};
+    std::vector<glm::vec3> m_uvs{};  // Atlas position and page per glyph index, next to typeface::metrics()
+    std::vector<glm::ivec2>     m_slots{};      // Atlas area reserved per glyph index, kept when a slot is reused
+    std::vector<std::uint64_t>  m_last_used{};  // Frame a glyph index was last pushed in
+    std::vector<std::uint32_t>  m_evicted{};    // Released from the typeface at the next reset
+    std::uint64_t  m_frame{1};
+    std::uint64_t  m_generation{0};
+    std::vector<skyline_packer> m_packers{};  // One per page
+    std::size_t    m_padding;
+    std::size_t    m_page_size{0};
+    std::size_t    m_min_size{0};
+    texture_array_ref_t m_texture{nullptr};
+    texture_ref_t       m_table{nullptr};
+    std::vector<glm::i16vec4> m_table_data{};
+    std::size_t m_table_first{limits<std::size_t>::max()};  // Entries [first, last) changed since the upload
+    std::size_t m_table_last{0};
     std::int32_t  m_max_delta_origin_ymin{0};
     std::int32_t  m_max_bearing_top{0};
     std::int32_t  m_max_bearing_left{0};
@@ -65,37 +135,88 @@ public:
     auto fonts() -> font_manager_ref_t { return m_manager; }
     auto typeface(std::string const& family, std::string const& style) -> typeface_ref_t;
 
-    auto text(std::string const& str, glm::vec3 const& position = {}, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> void;
-    auto text_size(std::string const& str, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> glm::vec2;
+    auto text(std::string_view str, glm::vec3 const& position = {}, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> void;
+    auto text_size(std::string_view str, glm::vec2 const& scale = glm::vec2{1.0f}, typeface_ref_t const& typeface = nullptr) -> glm::vec2;
+    // Lay str out into layout with the default typeface when none is given, see text_layout::update.
+    auto layout(text_layout& layout, std::string_view str, layout_props const& props = {}, typeface_ref_t const& typeface = nullptr) -> bool;
+    // Position is where text() would put the first line, the others go below it.
+    auto text(text_layout& layout, glm::vec3 const& position = {}, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+    // Lines [first, first + count) of the document, each below the previous one. Unchanged lines draw
+    // from their cached layout.
+    auto text(text_document& document, std::size_t first, std::size_t count, glm::vec3 const& position = {}, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+    // Only the lines inside the window, with the document scrolled down by scroll pixels. Position is where
+    // the first line goes at scroll 0. The first visible line is binary searched, so the cost follows the
+    // window's height and not the document's length.
+    auto text(text_document& document, float scroll, glm::vec3 const& position = {}, glm::vec4 const& color = glm::vec4{1.0f}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
+    // Lay the object's text out, its instances are written again at the next end() it is drawn in.
+    auto layout(text_object& object, std::string_view str, layout_props const& props = {}, typeface_ref_t const& typeface = nullptr) -> bool;
+    // Drawn from its own instance buffer at end(), the object has to outlive it.
+    auto text(text_object& object, float depth = 0.0f) -> void;
+    // Position is the grid's top left corner. Only the cells changed since its last draw are uploaded, the
+    // grid has to outlive end().
+    auto text(cell_grid& grid, glm::vec3 const& position = {}, glm::vec2 const& scale = glm::vec2{1.0f}) -> void;
 
     auto load(typeface_props const props) -> void;
+    // Text drawn with the handle's typeface uses the default one until a begin() adopts it.
+    auto load_async(typeface_props props) -> font_handle_ref_t;
     auto set_camera(glm::mat4 const& view, glm::mat4 const& projection) -> void {
         m_view       = view;
         m_projection = projection;
     }
     auto reload() -> void;
+    // Starts a new frame, fonts loaded in the background are adopted here. A content scale change is
+    // rendered in the background, typefaces keep drawing from their current atlas, scaled, and swap to
+    // the new one at the start of the frame it is done in.
     auto begin() -> void;
     auto end() -> void;
 
 private:
-    auto render_normal(text_batch const& batch) -> void;
-    auto render_subpixel(text_batch const& batch) -> void;
+    auto write_instances(text_object& object) -> void;
+    auto render_object(text_object const& object, float depth) -> void;
+    auto write_cells(cell_grid& grid) -> void;
+    auto render_grid(cell_grid const& grid, glm::vec3 const& position, glm::vec2 const& scale) -> void;
+    auto render(text_render_mode mode, text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void;
+    auto render_normal(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void;
+    auto render_sdf(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void;
+    auto render_msdf(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void;
+    auto render_subpixel(text_batch const& batch, attribute_descriptor const& descriptor, std::size_t instances) -> void;
+    auto render_batch(text_batch const& batch, shader_ref_t const& shader, attribute_descriptor const& descriptor, std::size_t instances) -> void;
 
 private:
     window_ref_t       m_window;
     font_manager_ref_t m_manager;
     typeface_ref_t     m_typeface{nullptr};      // Default typeface
+    double             m_content_scale{1.0};     // Window content scale the typefaces were last asked for
 
     index_buffer_ref_t  m_index_buffer{nullptr};
+    vertex_buffer_ref_t m_quad_buffer{nullptr};
     vertex_buffer_ref_t m_instance_buffer{nullptr};
     attribute_descriptor_ref_t m_descriptor{nullptr};
 
     shader_ref_t m_shader_normal{nullptr};
+    shader_ref_t m_shader_subpixel{nullptr};
+    shader_ref_t m_shader_sdf{nullptr};
+    shader_ref_t m_shader_msdf{nullptr};
+    shader_ref_t m_grid_normal{nullptr};
+    shader_ref_t m_grid_subpixel{nullptr};
+    shader_ref_t m_grid_sdf{nullptr};
+    shader_ref_t m_grid_msdf{nullptr};
     std::map<typeface_ref_t, text_batch> m_batches{};
+    shaped_run_cache m_runs{};
+    std::vector<std::pair<text_object*, float>> m_objects{};  // Drawn this frame, with their depth
+    std::vector<text_batch::gpu> m_object_data{};
+    struct queued_grid {
+        cell_grid* grid;
+        glm::vec3  position;
+        glm::vec2  scale;
+    };
+    std::vector<queued_grid> m_grids{};  // Drawn this frame
+    std::vector<std::pair<std::size_t, std::size_t>> m_cell_ranges{};
 
     glm::mat4 m_model{1.0f};
     glm::mat4 m_view{1.0f};
     glm::mat4 m_projection{1.0f};
+    glm::vec4 m_tint{1.0f};  // Multiplies the instance colors
 };
 
 using text_engine_ref_t = ref<text_engine>;
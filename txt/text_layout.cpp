@@ -0,0 +1,118 @@
+#include "text_layout.hpp"
+#include "unicode.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace txt {
+auto text_layout::update(typeface_ref_t const& face, std::string_view str, layout_props const& props) -> bool {
+    if (face == nullptr) throw std::runtime_error("Text layout needs a typeface!");
+    auto const same_props = props.max_width == m_props.max_width && props.align == m_props.align && props.line_spacing == m_props.line_spacing;
+    if (m_valid && face == m_typeface && face->generation() == m_generation && same_props && str == m_text) return false;
+    m_typeface = face;
+    m_props    = props;
+    if (str.data() != m_text.data()) m_text.assign(str);
+    layout();
+    m_generation = face->generation();
+    m_valid      = true;
+    return true;
+}
+auto text_layout::refresh() -> bool {
+    if (m_typeface == nullptr) return false;
+    return update(m_typeface, m_text, m_props);
+}
+
+auto text_layout::layout() -> void {
+    auto& face = *m_typeface;
+    // Looked up first, loading a glyph may grow the glyphs and metrics referenced below.
+    auto const empty_height = face.glyphs()[face.index(' ')].advance_y;
+    shape(face, m_text, m_run);
+    m_codes.clear();
+    for_each_codepoint(m_text, [&](std::uint32_t code) { m_codes.push_back(code); });
+    line_breaks(m_codes, m_breaks);
+
+    m_indices.clear();
+    m_positions.clear();
+    m_lines.clear();
+    m_size  = glm::vec2{0.0f};
+    m_pen_y = 0.0f;
+
+    // Wrapping is decided in 26.6 pixels, same as the run offsets.
+    auto const unit  = face.layout_scale() / 64.0f;
+    auto const limit = m_props.max_width > 0.0f ? std::int64_t(m_props.max_width / unit) : std::int64_t(0);
+    auto const& advances = face.metrics().advance_x;
+    std::size_t first = 0;
+    std::size_t brk   = 0;  // Last break opportunity of the line, first when there is none yet
+    for (std::size_t i = 0; i < m_codes.size();) {
+        if (i > first && m_breaks[i] == break_action::mandatory) {
+            end_line(first, i, empty_height);
+            first = brk = i;
+            continue;
+        }
+        if (i > first && m_breaks[i] == break_action::allowed) brk = i;
+        auto const cls = line_break_class_of(m_codes[i]);
+        // Spaces and line ends hang past the edge.
+        if (limit > 0 && i > first && cls != line_break_class::SP && !is_line_end(cls)) {
+            auto const right = m_run.offsets[i] + advances[m_run.indices[i]] - m_run.offsets[first];
+            if (right > limit) {
+                // A word wider than the line alone is broken where it overflows.
+                auto const at = brk > first ? brk : i;
+                end_line(first, at, empty_height);
+                first = brk = i = at;
+                continue;
+            }
+        }
+        ++i;
+    }
+    end_line(first, m_codes.size(), empty_height);
+    // Text ending with a line end has an empty last line, the way an editor shows it.
+    if (!m_codes.empty() && is_line_end(line_break_class_of(m_codes.back())))
+        end_line(m_codes.size(), m_codes.size(), empty_height);
+
+    for (auto const& line : m_lines) {
+        auto const room = (m_props.max_width > 0.0f ? m_props.max_width : m_size.x) - line.width;
+        auto offset = 0.0f;
+        if (m_props.align == text_align::center) offset = std::max(room, 0.0f) / 2.0f;
+        else if (m_props.align == text_align::right) offset = std::max(room, 0.0f);
+        for (auto i = line.first; i < line.first + line.count; ++i)
+            m_positions[i].x += offset;
+    }
+}
+auto text_layout::end_line(std::size_t first, std::size_t last, std::int64_t empty_height) -> void {
+    auto const& face = *m_typeface;
+    auto const unit  = face.layout_scale() / 64.0f;
+
+    std::int64_t height = 0;
+    for (auto i = first; i < last; ++i)
+        height = std::max(height, face.glyphs()[m_run.indices[i]].advance_y);
+    if (height == 0) height = empty_height;
+    // Line ends and trailing spaces are neither drawn nor measured.
+    auto end = last;
+    while (end > first) {
+        auto const cls = line_break_class_of(m_codes[end - 1]);
+        if (cls != line_break_class::SP && !is_line_end(cls)) break;
+        --end;
+    }
+
+    auto const line_height = float(height) * unit;
+    if (!m_lines.empty()) m_pen_y -= line_height * m_props.line_spacing;
+    m_size.y += m_lines.empty() ? line_height : line_height * m_props.line_spacing;
+
+    layout_line line{
+        .first    = m_indices.size(),
+        .count    = end - first,
+        .width    = 0.0f,
+        .baseline = m_pen_y,
+    };
+    if (end > first) {
+        auto const& advances = face.metrics().advance_x;
+        line.width = float(m_run.offsets[end - 1] + advances[m_run.indices[end - 1]] - m_run.offsets[first]) * unit;
+    }
+    for (auto i = first; i < end; ++i) {
+        m_indices.push_back(m_run.indices[i]);
+        m_positions.push_back({float(m_run.offsets[i] - m_run.offsets[first]) * unit, m_pen_y});
+    }
+    m_size.x = std::max(m_size.x, line.width);
+    m_lines.push_back(line);
+}
+} // namespace txt
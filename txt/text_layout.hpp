@@ -0,0 +1,82 @@
+#ifndef TXT_TEXT_LAYOUT_HPP
+#define TXT_TEXT_LAYOUT_HPP
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+#include "utility.hpp"
+#include "fonts.hpp"
+#include "shaping.hpp"
+#include "line_break.hpp"
+
+namespace txt {
+enum class text_align {
+    left,
+    center,
+    right
+};
+
+struct layout_props {
+    float      max_width{0.0f};     // Layout units at scale 1, lines wrap at break opportunities past it. 0 never wraps.
+    text_align align{text_align::left};
+    float      line_spacing{1.0f};  // Multiple of the line height, the tallest glyph::advance_y of the line
+};
+
+struct layout_line {
+    std::size_t first{0};     // Range of glyphs in text_layout::indices() and positions()
+    std::size_t count{0};
+    float       width{0.0f};  // Trailing spaces not included
+    float       baseline{0.0f};
+};
+
+// Multi-line text laid out in layout units at scale 1: glyph indices of the typeface and the pen position
+// of every glyph. The first line's baseline is at 0 and lines go down. Wrapping follows UAX #14 and
+// breaks inside a word only when the word alone is wider than the line.
+class text_layout {
+public:
+    text_layout() = default;
+    ~text_layout() = default;
+
+    auto typeface() const -> typeface_ref_t const& { return m_typeface; }
+    auto props() const -> layout_props const& { return m_props; }
+    auto indices() const -> std::vector<std::uint32_t> const& { return m_indices; }
+    auto positions() const -> std::vector<glm::vec2> const& { return m_positions; }
+    auto lines() const -> std::vector<layout_line> const& { return m_lines; }
+    auto size() const -> glm::vec2 const& { return m_size; }
+    auto text() const -> std::string const& { return m_text; }
+
+    // Lays the text out again only when the text, typeface or props changed, or the typeface's glyphs did.
+    // Returns true when it did.
+    auto update(typeface_ref_t const& face, std::string_view str, layout_props const& props = {}) -> bool;
+    // Same text and props, only lays out again when the typeface's glyphs changed, e.g. after an eviction.
+    auto refresh() -> bool;
+
+private:
+    auto layout() -> void;
+    auto end_line(std::size_t first, std::size_t last, std::int64_t empty_height) -> void;
+
+private:
+    typeface_ref_t   m_typeface{nullptr};
+    std::uint64_t    m_generation{0};
+    std::string      m_text{};
+    layout_props     m_props{};
+    bool             m_valid{false};
+
+    // Scratch, one entry per codepoint
+    shaped_run                 m_run{};
+    std::vector<std::uint32_t> m_codes{};
+    std::vector<break_action>  m_breaks{};
+
+    std::vector<std::uint32_t> m_indices{};
+    std::vector<glm::vec2>     m_positions{};
+    std::vector<layout_line>   m_lines{};
+    glm::vec2                  m_size{0.0f};
+    float                      m_pen_y{0.0f};
+};
+} // namespace txt
+
+#endif  // TXT_TEXT_LAYOUT_HPP
@@ -0,0 +1,55 @@
+#ifndef TXT_TEXT_OBJECT_HPP
+#define TXT_TEXT_OBJECT_HPP
+#include <cstdint>
+#include <cstddef>
+
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+
+#include "utility.hpp"
+#include "buffer.hpp"
+#include "text_layout.hpp"
+
+namespace txt {
+class text_engine;
+
+// Retained text, laid out once with its glyph instances kept in a buffer of its own on the GPU. Position,
+// color and scale are applied while drawing, changing them doesn't touch the instances. They're written
+// again only when the text changed or the glyphs moved in the atlas, e.g. after a repack or a new
+// content scale. Instances are relative to the object's position and reach 8192 pixels from it in either
+// direction, glyphs laid out further away aren't drawn.
+class text_object {
+public:
+    text_object() = default;
+    ~text_object() = default;
+    text_object(text_object const&) = delete;
+    auto operator=(text_object const&) -> text_object& = delete;
+
+    auto layout() const -> text_layout const& { return m_layout; }
+    auto size() const -> glm::vec2 { return m_layout.size() * m_scale; }
+
+    // Position is where text() would put the first line.
+    auto position() const -> glm::vec2 const& { return m_position; }
+    auto color() const -> glm::vec4 const& { return m_color; }
+    auto scale() const -> glm::vec2 const& { return m_scale; }
+    auto set_position(glm::vec2 const& position) -> void { m_position = position; }
+    auto set_color(glm::vec4 const& color) -> void { m_color = color; }
+    auto set_scale(glm::vec2 const& scale) -> void { m_scale = scale; }
+
+private:
+    friend class text_engine;
+
+    text_layout m_layout{};
+    bool        m_dirty{true};   // Instances don't match the layout
+    std::uint64_t m_atlas{0};    // Generation of the atlas the instances were written for
+    std::size_t   m_instances{0};
+    vertex_buffer_ref_t        m_buffer{nullptr};
+    attribute_descriptor_ref_t m_descriptor{nullptr};
+
+    glm::vec2 m_position{0.0f};
+    glm::vec4 m_color{1.0f};
+    glm::vec2 m_scale{1.0f};
+};
+} // namespace txt
+
+#endif  // TXT_TEXT_OBJECT_HPP
@@ -1,4 +1,6 @@
 #include "texture.hpp"
+#include <algorithm>
+#include <bit>
 
 #ifndef __EMSCRIPTEN__
 #include "glad/glad.h"
@@ -7,12 +9,23 @@
 #endif
 
 namespace txt {
-constexpr auto gl_texture_internal_format(pixel_fmt value) -> GLint {
+constexpr auto gl_texture_internal_format(pixel_fmt value, txt::type data_type) -> GLint {
     switch (value) {
         case pixel_fmt::red:  return GL_R8;
         case pixel_fmt::rg:   return GL_RG;
         case pixel_fmt::rgb:  return GL_RGB;
         case pixel_fmt::rgba: return GL_RGBA;
+        // Integer textures are sized by their data, they're read with texelFetch and never filtered.
+        case pixel_fmt::rgba_integer:
+            switch (data_type) {
+                case txt::type::u8:  return GL_RGBA8UI;
+                case txt::type::i8:  return GL_RGBA8I;
+                case txt::type::u16: return GL_RGBA16UI;
+                case txt::type::i16: return GL_RGBA16I;
+                case txt::type::u32: return GL_RGBA32UI;
+                case txt::type::i32: return GL_RGBA32I;
+                default: throw std::runtime_error("Unknown integer texture data type!");
+            }
         default: throw std::runtime_error("Unknown texture internal format!");
     }
 }
@@ -22,6 +35,7 @@ constexpr auto gl_texture_format(pixel_fmt value) -> GLenum {
         case pixel_fmt::rg:   return GL_RG;
         case pixel_fmt::rgb:  return GL_RGB;
         case pixel_fmt::rgba: return GL_RGBA;
+        case pixel_fmt::rgba_integer: return GL_RGBA_INTEGER;
         default: throw std::runtime_error("Unknown texture format!");
     }
 }
@@ -75,6 +89,36 @@ auto make_texture(image_u8_ref_t img, texture_props const& props) -> texture_ref
     });
 }
 
+auto make_texture_array(image_u8 const& img, std::size_t const& layers, texture_props const& props) -> texture_array_ref_t {
+    return make_ref<texture_array>(img.data(), img.width(), img.height() / layers, layers, img.channels(), texture_props{
+        .internal = infer_format_from_channels(img.channels()),
+        .format   = infer_format_from_channels(img.channels()),
+        .min_filter = props.min_filter,
+        .mag_filter = props.mag_filter,
+        .wrap_s = props.wrap_s,
+        .wrap_t = props.wrap_t,
+        .wrap_r = props.wrap_r,
+        .mipmap = false  // Mipmaps would have to be regenerated for every layer on each upload
+    });
+}
+
+auto max_texture_size() -> std::size_t {
+    static auto const size = [] {
+        GLint value{0};
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
+        return std::size_t(std::max(value, 2048));  // Minimum guaranteed by GL 4.1 and WebGL 2
+    }();
+    return size;
+}
+auto max_texture_layers() -> std::size_t {
+    static auto const layers = [] {
+        GLint value{0};
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &value);
+        return std::size_t(std::max(value, 256));
+    }();
+    return layers;
+}
+
 texture::texture(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& channels, texture_props const& props)
     : m_id(0)
     , m_width(width)
@@ -103,9 +147,11 @@ auto texture::set(void const* data, std::size_t const& width, std::size_t const&
     m_width    = width;
     m_height   = height;
     m_channels = channels;
+    m_format    = props.format;
+    m_data_type = props.data_type;
 
     glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, gl_texture_internal_format(props.internal), GLsizei(m_width), GLsizei(m_height), 0, gl_texture_format(props.format), gl_type(props.data_type), data);
+    glTexImage2D(GL_TEXTURE_2D, 0, gl_texture_internal_format(props.internal, props.data_type), GLsizei(m_width), GLsizei(m_height), 0, gl_texture_format(props.format), gl_type(props.data_type), data);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, gl_texture_wrap(props.wrap_s));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, gl_texture_wrap(props.wrap_t));
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_texture_filter(props.min_filter));
@@ -113,6 +159,20 @@ auto texture::set(void const* data, std::size_t const& width, std::size_t const&
     if (props.mipmap) glGenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
+auto texture::sub(void const* data, std::size_t const& x, std::size_t const& y, std::size_t const& width, std::size_t const& height, std::size_t const& row_length) -> void {
+    if (width == 0 || height == 0) return;
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(row_length));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, GLint(x), GLint(y), GLsizei(width), GLsizei(height), gl_texture_format(m_format), gl_type(m_data_type), data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+auto texture::sub(image_u8 const& img, std::size_t const& x, std::size_t const& y, std::size_t const& width, std::size_t const& height) -> void {
+    auto const offset = (y * img.width() + x) * img.channels();
+    sub(img.data() + offset, x, y, width, height, img.width());
+}
 auto texture::bind(std::size_t const& slot) const -> void {
     glActiveTexture(GL_TEXTURE0 + std::uint32_t(slot));
     glBindTexture(GL_TEXTURE_2D, m_id);
@@ -121,4 +181,89 @@ auto texture::unbind(std::size_t const& slot) const -> void {
     glActiveTexture(GL_TEXTURE0 + std::uint32_t(slot));
     glBindTexture(GL_TEXTURE_2D, 0);
 }
+
+texture_array::texture_array(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& layers, std::size_t const& channels, texture_props const& props)
+    : m_id(0) {
+    glGenTextures(1, &m_id);
+    set(data, width, height, layers, channels, props);
+}
+texture_array::~texture_array() {
+    glDeleteTextures(1, &m_id);
+}
+
+auto texture_array::set(image_u8 const& img, std::size_t const& layers, texture_props const& props) -> void {
+    set(img.data(), img.width(), img.height() / layers, layers, img.channels(), {
+        .internal = infer_format_from_channels(img.channels()),
+        .format   = infer_format_from_channels(img.channels()),
+        .min_filter = props.min_filter,
+        .mag_filter = props.mag_filter,
+        .wrap_s = props.wrap_s,
+        .wrap_t = props.wrap_t,
+        .wrap_r = props.wrap_r,
+        .mipmap = false
+    });
+}
+auto texture_array::set(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& layers, std::size_t const& channels, texture_props const& props) -> void {
+    m_width    = width;
+    m_height   = height;
+    m_layers   = layers;
+    m_channels = channels;
+    m_props    = props;
+    allocate(std::bit_ceil(layers));
+    upload(data, 0, layers);
+}
+auto texture_array::add_layers(void const* data, std::size_t const& layers) -> void {
+    if (layers <= m_layers) return;
+    auto const first = m_layers;
+    m_layers = layers;
+    if (layers <= m_capacity) {
+        upload(data, first, layers - first);
+        return;
+    }
+    // Out of layers, texture storage can't grow in place.
+    allocate(std::bit_ceil(layers));
+    upload(data, 0, layers);
+}
+auto texture_array::sub(void const* data, std::size_t const& x, std::size_t const& y, std::size_t const& layer, std::size_t const& width, std::size_t const& height, std::size_t const& row_length) -> void {
+    if (width == 0 || height == 0) return;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, GLint(row_length));
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, GLint(x), GLint(y), GLint(layer), GLsizei(width), GLsizei(height), 1, gl_texture_format(m_props.format), gl_type(m_props.data_type), data);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+auto texture_array::sub(image_u8 const& img, std::size_t const& x, std::size_t const& y, std::size_t const& layer, std::size_t const& width, std::size_t const& height) -> void {
+    auto const offset = ((layer * m_height + y) * img.width() + x) * img.channels();
+    sub(img.data() + offset, x, y, layer, width, height, img.width());
+}
+auto texture_array::bind(std::size_t const& slot) const -> void {
+    glActiveTexture(GL_TEXTURE0 + std::uint32_t(slot));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+}
+auto texture_array::unbind(std::size_t const& slot) const -> void {
+    glActiveTexture(GL_TEXTURE0 + std::uint32_t(slot));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+auto texture_array::allocate(std::size_t const& capacity) -> void {
+    m_capacity = capacity;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, gl_texture_internal_format(m_props.internal, m_props.data_type), GLsizei(m_width), GLsizei(m_height), GLsizei(m_capacity), 0, gl_texture_format(m_props.format), gl_type(m_props.data_type), nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, gl_texture_wrap(m_props.wrap_s));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, gl_texture_wrap(m_props.wrap_t));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, gl_texture_filter(m_props.min_filter));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, gl_texture_filter(m_props.mag_filter));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+auto texture_array::upload(void const* data, std::size_t const& first, std::size_t const& count) -> void {
+    if (data == nullptr || count == 0) return;
+    auto const layer_bytes = m_width * m_height * m_channels;  // u8 layers only, see make_texture_array
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, GLint(first), GLsizei(m_width), GLsizei(m_height), GLsizei(count), gl_texture_format(m_props.format), gl_type(m_props.data_type), static_cast<std::uint8_t const*>(data) + first * layer_bytes);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
 }
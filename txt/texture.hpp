@@ -83,6 +83,10 @@ public:
 
     auto set(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& channels, texture_props const& props = {}) -> void;
     auto set(image_u8_ref_t img, texture_props const& props = {}) -> void;
+    // Update a sub-rectangle, row_length is the pixel stride of data and 0 means tightly packed.
+    auto sub(void const* data, std::size_t const& x, std::size_t const& y, std::size_t const& width, std::size_t const& height, std::size_t const& row_length = 0) -> void;
+    // Upload the region of img at the same position in the texture.
+    auto sub(image_u8 const& img, std::size_t const& x, std::size_t const& y, std::size_t const& width, std::size_t const& height) -> void;
     auto bind(std::size_t const& slot = 0) const -> void;
     auto unbind(std::size_t const& slot = 0) const -> void;
 
@@ -91,11 +95,62 @@ private:
     std::size_t   m_width;
     std::size_t   m_height;
     std::size_t   m_channels;
+    pixel_fmt     m_format{pixel_fmt::rgba};
+    txt::type     m_data_type{txt::type::u8};
+};
+
+// Layers of equal size sampled as one texture (sampler2DArray). Layer data is read from images holding
+// every layer stacked on top of each other, layer n starts at row n * height. Storage is allocated for
+// the layers needed rounded up to a power of two, adding a layer only uploads that layer until the
+// capacity runs out.
+class texture_array {
+public:
+    texture_array(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& layers, std::size_t const& channels, texture_props const& props = {});
+    ~texture_array();
+    texture_array(texture_array const&) = delete;
+    auto operator=(texture_array const&) -> texture_array& = delete;
+
+    auto id() const -> std::uint32_t { return m_id; }
+    auto width() const -> std::size_t { return m_width; }
+    auto height() const -> std::size_t { return m_height; }
+    auto layers() const -> std::size_t { return m_layers; }
+    auto capacity() const -> std::size_t { return m_capacity; }
+
+    // Reallocate and upload every layer.
+    auto set(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& layers, std::size_t const& channels, texture_props const& props = {}) -> void;
+    auto set(image_u8 const& img, std::size_t const& layers, texture_props const& props = {}) -> void;
+    // Grow to layers, data holds all of them. Only the new layers are uploaded while they fit the capacity.
+    auto add_layers(void const* data, std::size_t const& layers) -> void;
+    // Update a sub-rectangle of one layer, row_length is the pixel stride of data and 0 means tightly packed.
+    auto sub(void const* data, std::size_t const& x, std::size_t const& y, std::size_t const& layer, std::size_t const& width, std::size_t const& height, std::size_t const& row_length = 0) -> void;
+    // Upload the region of the stacked img at the same position in the layer.
+    auto sub(image_u8 const& img, std::size_t const& x, std::size_t const& y, std::size_t const& layer, std::size_t const& width, std::size_t const& height) -> void;
+    auto bind(std::size_t const& slot = 0) const -> void;
+    auto unbind(std::size_t const& slot = 0) const -> void;
+
+private:
+    auto allocate(std::size_t const& capacity) -> void;
+    auto upload(void const* data, std::size_t const& first, std::size_t const& count) -> void;
+
+private:
+    std::uint32_t m_id;
+    std::size_t   m_width{0};
+    std::size_t   m_height{0};
+    std::size_t   m_layers{0};
+    std::size_t   m_capacity{0};
+    std::size_t   m_channels{0};
+    texture_props m_props{};
 };
 
 using texture_ref_t = ref<texture>;
+using texture_array_ref_t = ref<texture_array>;
 auto make_texture(void const* data, std::size_t const& width, std::size_t const& height, std::size_t const& channels, texture_props const& props) -> texture_ref_t;
 auto make_texture(image_u8_ref_t img, texture_props const& props = {}) -> texture_ref_t;
+auto make_texture_array(image_u8 const& img, std::size_t const& layers, texture_props const& props = {}) -> texture_array_ref_t;
+
+// Limits of the current context, queried once.
+auto max_texture_size() -> std::size_t;
+auto max_texture_layers() -> std::size_t;
 }
 
 #endif  // TXT_TEXTURE_HPP
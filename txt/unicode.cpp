@@ -0,0 +1,75 @@
+#include "unicode.hpp"
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TXT_UNICODE_SSE2
+#endif
+
+namespace txt {
+auto ascii_prefix(std::uint8_t const* data, std::size_t size) -> std::size_t {
+    std::size_t i = 0;
+#ifdef TXT_UNICODE_SSE2
+    for (; i + 16 <= size; i += 16) {
+        auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+        auto const mask  = std::uint32_t(_mm_movemask_epi8(chunk));  // Top bit of every byte
+        if (mask != 0) return i + std::size_t(std::countr_zero(mask));
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word{};
+        std::memcpy(&word, data + i, sizeof(word));
+        auto const mask = word & 0x8080808080808080ull;
+        if (mask != 0) {
+            if constexpr (std::endian::native == std::endian::little)
+                return i + std::size_t(std::countr_zero(mask) / 8);
+            else
+                return i + std::size_t(std::countl_zero(mask) / 8);
+        }
+    }
+    for (; i < size; ++i) {
+        if (data[i] >= 0x80) return i;
+    }
+    return size;
+}
+
+auto decode_utf8(std::uint8_t const*& it, std::uint8_t const* end) -> std::uint32_t {
+    auto const lead = *it++;
+    if (lead < 0x80) return lead;
+
+    // Length and the valid range of the second byte, the range rules out overlong forms, surrogates
+    // and codepoints above U+10FFFF.
+    std::size_t   length = 0;
+    std::uint8_t  low    = 0x80;
+    std::uint8_t  high   = 0xBF;
+    std::uint32_t code   = 0;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        code   = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        code   = lead & 0x0F;
+        if (lead == 0xE0) low = 0xA0;
+        if (lead == 0xED) high = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        code   = lead & 0x07;
+        if (lead == 0xF0) low = 0x90;
+        if (lead == 0xF4) high = 0x8F;
+    } else {
+        return replacement_character;  // Continuation byte or invalid lead
+    }
+
+    for (std::size_t i = 1; i < length; ++i) {
+        if (it == end) return replacement_character;
+        auto const byte = *it;
+        if (byte < low || byte > high) return replacement_character;  // Not consumed, starts the next one
+        code = (code << 6) | (byte & 0x3F);
+        low  = 0x80;
+        high = 0xBF;
+        ++it;
+    }
+    return code;
+}
+} // namespace txt
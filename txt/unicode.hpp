@@ -0,0 +1,35 @@
+#ifndef TXT_UNICODE_HPP
+#define TXT_UNICODE_HPP
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace txt {
+constexpr std::uint32_t replacement_character{0xFFFD};
+
+// Number of leading bytes below 0x80, 16 bytes at a time with SSE2 and 8 at a time elsewhere.
+auto ascii_prefix(std::uint8_t const* data, std::size_t size) -> std::size_t;
+// Decode one codepoint starting at it and advance past it. Invalid or truncated sequences decode as
+// U+FFFD and advance past their maximal valid prefix, as recommended by the Unicode standard.
+auto decode_utf8(std::uint8_t const*& it, std::uint8_t const* end) -> std::uint32_t;
+
+// Call f with every codepoint of the UTF-8 string, in place without allocating. ASCII spans skip the
+// decoder entirely.
+template <typename F>
+auto for_each_codepoint(std::string_view str, F&& f) -> void {
+    auto const* it  = reinterpret_cast<std::uint8_t const*>(str.data());
+    auto const* end = it + str.size();
+    while (it != end) {
+        auto const* ascii_end = it + ascii_prefix(it, std::size_t(end - it));
+        for (; it != ascii_end; ++it)
+            f(std::uint32_t(*it));
+        if (it != end) f(decode_utf8(it, end));
+    }
+}
+
+inline auto as_string_view(std::u8string_view str) -> std::string_view {
+    return {reinterpret_cast<char const*>(str.data()), str.size()};
+}
+} // namespace txt
+
+#endif  // TXT_UNICODE_HPP
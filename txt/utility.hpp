@@ -2,6 +2,7 @@
 #define TXT_UTILITY_HPP
 #include <memory>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <functional>
 #include <type_traits>
@@ -43,6 +44,22 @@ constexpr auto make_local(Args&&... args) -> local<T> {
     return std::make_unique<T>(std::forward<Args>(args)...);
 }
 
+// FNV-1a 64-bit hash, used for cache keys.
+inline constexpr std::uint64_t fnv1a_basis = 0xcbf29ce484222325ull;
+inline auto fnv1a(void const* data, std::size_t bytes, std::uint64_t hash = fnv1a_basis) -> std::uint64_t {
+    auto const bytes_ptr = static_cast<std::uint8_t const*>(data);
+    for (std::size_t i = 0; i < bytes; ++i) {
+        hash ^= bytes_ptr[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+inline auto fnv1a_value(T const& value, std::uint64_t hash = fnv1a_basis) -> std::uint64_t {
+    return fnv1a(&value, sizeof(T), hash);
+}
+
 // Math constants
 inline constexpr auto pi    = std::numbers::pi;
 inline constexpr auto pif32 = std::numbers::pi_v<float>;
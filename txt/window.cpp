@@ -216,7 +216,7 @@ auto window::setup_native() -> void {
     float content_scale_x, content_scale_y;
     glfwGetWindowContentScale(static_cast<GLFWwindow*>(m_native), &content_scale_x, &content_scale_y);
     m_content_scale_x = double(content_scale_x);
-    m_content_scale_x = double(content_scale_y);
+    m_content_scale_y = double(content_scale_y);
 }
 auto window::clean_native() -> void {
     glfwDestroyWindow(static_cast<GLFWwindow*>(m_native));